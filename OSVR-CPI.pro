@@ -23,24 +23,40 @@ TEMPLATE = app
 SOURCES += main.cpp\
         mainwindow.cpp \
     osvruser.cpp \
+    lib_json/json_batch.cpp \
+    lib_json/json_lazy.cpp \
     lib_json/json_reader.cpp \
+    lib_json/json_resource.cpp \
+    lib_json/json_sink.cpp \
     lib_json/json_value.cpp \
     lib_json/json_writer.cpp \
     firmwareupdateprogressdialog.cpp
 
 HEADERS  += mainwindow.h \
     osvruser.h \
+    json/arena.h \
     json/assertions.h \
     json/autolink.h \
+    json/batch.h \
+    json/binding.h \
     json/config.h \
     json/features.h \
+    json/flatarray.h \
+    json/flatmap.h \
     json/forwards.h \
     json/json.h \
+    json/keytable.h \
+    json/lazy.h \
     json/reader.h \
+    json/resource.h \
+    json/sink.h \
     json/value.h \
     json/version.h \
     json/writer.h \
     lib_json/json_batchallocator.h \
+    lib_json/json_dtoa.h \
+    lib_json/json_scanner.h \
+    lib_json/json_strtod.h \
     lib_json/json_tool.h \
     version.h \
     firmwareupdateprogressdialog.h
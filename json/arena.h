@@ -0,0 +1,80 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_ARENA_H_INCLUDED
+#define CPPTL_JSON_ARENA_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "resource.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstddef>
+
+namespace Json {
+
+/** \brief Monotonic memory arena for Value trees.
+ *
+ * Memory is handed out from large blocks and never given back one
+ * allocation at a time: everything is freed at once by release() or by
+ * the destructor. Reader::setArena() uses it to allocate the containers,
+ * member names, strings and comments of a parsed tree, so that building
+ * the tree does not call malloc for each of them, and destroying it does
+ * not call free for each of them.
+ *
+ * Values allocated from an arena must be destroyed before the arena is
+ * released. Copying such a Value gives an ordinary, independent Value.
+ *
+ * Example of usage:
+ * \code
+ * Json::ValueArena arena;  // declared first, so destroyed last
+ * Json::Reader reader;
+ * reader.setArena(&arena);
+ * Json::Value root;
+ * reader.parseFile("osvr_user_settings.json", root);
+ * \endcode
+ *
+ * A ValueArena is not thread-safe.
+ */
+class JSON_API ValueArena : public MemoryResource {
+public:
+  /// \param blockSize Size of the first block. Following blocks are twice
+  /// as large as the previous one, up to a limit.
+  explicit ValueArena(size_t blockSize = 4096);
+  ~ValueArena();
+
+  /// Returns \a size bytes aligned for any Value member. Never returns 0.
+  void* allocate(size_t size);
+
+  /** \brief Free all allocations at once.
+   * The largest block is kept for the next allocations, so that parsing
+   * documents of similar sizes in turn with the same arena does not
+   * allocate anything after the first one.
+   */
+  void release();
+
+protected:
+  virtual void* doAllocate(size_t size);
+  virtual void doDeallocate(void* memory, size_t size);
+
+private:
+  struct Block {
+    Block* next_;
+    size_t size_;
+  };
+
+  // disabled copy constructor and assignement operator.
+  ValueArena(const ValueArena&);
+  void operator=(const ValueArena&);
+
+  void* allocateBlock(size_t size);
+
+  Block* blocks_;
+  char* current_;
+  char* end_;
+  size_t blockSize_;
+};
+
+} // namespace Json
+
+#endif // CPPTL_JSON_ARENA_H_INCLUDED
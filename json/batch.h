@@ -0,0 +1,147 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_BATCH_H_INCLUDED
+#define CPPTL_JSON_BATCH_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "features.h"
+#include "reader.h"
+#include "value.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <string>
+#include <vector>
+
+// Disable warning C4251: <data member>: <type> needs to have dll-interface to
+// be used by...
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif // if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+
+namespace Json {
+
+/** \brief Outcome of the parsing of one document by a BatchReader.
+ */
+struct JSON_API BatchResult {
+  BatchResult();
+
+  /// \c true if the document was successfully parsed.
+  bool ok;
+  /// Root value of the document, only meaningful if ok is \c true.
+  Value root;
+  /// Offset of the document in the parsed buffer, for JSON Lines. Error
+  /// offsets are relative to the document itself.
+  size_t offset;
+  /// 1-based line of the document in the parsed buffer, for JSON Lines.
+  size_t line;
+  /// \see Reader::getStructuredErrors()
+  std::vector<Reader::StructuredError> errors;
+  /// \see Reader::getFormattedErrorMessages()
+  std::string errorMessages;
+};
+
+/** \brief Parse many <a HREF="http://www.json.org">JSON</a> documents
+ * concurrently.
+ *
+ * Each call spreads the documents over the calling thread and threads
+ * started for the call, each with its own Reader, and joins them before
+ * returning. Every thread starts with a contiguous share of the documents
+ * and, once done with it, steals half of the remaining documents of the
+ * busiest other thread, so that a few large documents do not leave the
+ * other threads idle. That also hands the share of a thread the system
+ * could not start to the others.
+ *
+ * Results always come back in input order. When the library is built
+ * without C++11 threads (see JSON_HAS_STD_THREAD), documents are parsed
+ * one after the other by the calling thread.
+ *
+ * Example of usage:
+ * \code
+ * Json::BatchReader batch;
+ * std::vector<Json::BatchResult> results;
+ * if (!batch.parseFiles(profilePaths, results))
+ *   for (size_t i = 0; i < results.size(); ++i)
+ *     if (!results[i].ok)
+ *       std::cerr << profilePaths[i] << results[i].errorMessages;
+ * \endcode
+ */
+class JSON_API BatchReader {
+public:
+  /** \brief Constructs a BatchReader allowing all features
+   * for parsing, using one thread per processor.
+   */
+  BatchReader();
+
+  /** \brief Constructs a BatchReader allowing the specified feature set
+   * for parsing.
+   * \param features Features given to the Reader of each thread.
+   * \param threadCount Number of threads, 0 for one per processor.
+   */
+  BatchReader(const Features& features, unsigned int threadCount = 0);
+
+  /** \brief Intern member names in \a keyTable, shared by all threads.
+   * Documents of a collection usually repeat the same names: interning
+   * them keeps a single copy of each for the whole batch.
+   * \see Reader::setKeyTable()
+   */
+  void setKeyTable(KeyTable* keyTable);
+
+  /** \brief Parse a <a HREF="http://jsonlines.org">JSON Lines</a> buffer.
+   * Each line holds one document and may end with "\r\n". Lines that only
+   * contain whitespace are skipped and produce no result.
+   * \param results [out] One result per document, in order.
+   * \param collectComments See Reader::parse(const std::string&, Value&,
+   * bool). Comments can not span several lines in JSON Lines.
+   * \return \c true if every document was successfully parsed.
+   */
+  bool parseLines(const char* beginDoc,
+                  const char* endDoc,
+                  std::vector<BatchResult>& results,
+                  bool collectComments = false);
+
+  /// Same as parseLines(const char*, const char*, std::vector<BatchResult>&,
+  /// bool).
+  bool parseLines(const std::string& document,
+                  std::vector<BatchResult>& results,
+                  bool collectComments = false);
+
+  /** \brief Parse a list of files with Reader::parseFile().
+   * \param results [out] One result per file, in the order of \a paths.
+   * \return \c true if every file was successfully parsed.
+   */
+  bool parseFiles(const std::vector<std::string>& paths,
+                  std::vector<BatchResult>& results,
+                  bool collectComments = true);
+
+private:
+  struct Job {
+    const char* begin_;
+    const char* end_;
+    const std::string* path_;
+    size_t offset_;
+    size_t line_;
+  };
+
+  static void parseJob(Reader& reader,
+                       const Job& job,
+                       BatchResult& result,
+                       bool collectComments);
+  bool run(const std::vector<Job>& jobs,
+           std::vector<BatchResult>& results,
+           bool collectComments) const;
+
+  Features features_;
+  unsigned int threadCount_;
+  KeyTable* keyTable_;
+};
+
+} // namespace Json
+
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(pop)
+#endif // if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+
+#endif // CPPTL_JSON_BATCH_H_INCLUDED
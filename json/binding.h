@@ -0,0 +1,688 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_BINDING_H_INCLUDED
+#define CPPTL_JSON_BINDING_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "reader.h"
+#include "writer.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Json {
+
+/** \brief Describes the JSON object a struct is read from and written as.
+ *
+ * Specialize Binding for a struct to read it with BindingReader and write it
+ * with writeObject(), without going through a Value. The specialization
+ * lists the members of the object in a static member template:
+ * \code
+ * namespace Json {
+ * template <> struct Binding<Eye> {
+ *   template <typename Visitor, typename Object>
+ *   static void describe(Visitor& visitor, Object& eye) {
+ *     visitor.beginGroup("correction");
+ *     visitor.field("spherical", eye.spherical);
+ *     visitor.endGroup();
+ *     visitor.field("dominant", eye.dominant);
+ *   }
+ * };
+ * }
+ * \endcode
+ *
+ * \c Object is the struct when reading, and the const struct when writing.
+ * field() binds a member of type bool, Int, UInt, Int64, UInt64, double or
+ * std::string, or a member of another struct that has a Binding, which is
+ * then a nested object. beginGroup() and endGroup() enclose members that go
+ * in a nested object of their own, like "correction" above. Members are
+ * written in the order they are listed.
+ *
+ * Names must be string literals: their length is part of their type, so
+ * that each visitor is instantiated with the names as constants, and finding
+ * the member of a key compares lengths before characters, without any table
+ * built at run time.
+ */
+template <typename T> struct Binding;
+
+/** \brief Member of a bound struct that a value is stored into.
+ * Filled by the visitors of BindingReader; not meant to be used directly.
+ */
+struct BindingTarget {
+  enum Kind {
+    none, ///< Not a bound member: the value is skipped.
+    boolField,
+    intField,
+    uintField,
+#if defined(JSON_HAS_INT64)
+    int64Field,
+    uint64Field,
+#endif // if defined(JSON_HAS_INT64)
+    doubleField,
+    stringField,
+    objectField, ///< A struct with a Binding.
+    groupField   ///< A group of the members of a struct.
+  };
+
+  typedef void (*Find)(void* object,
+                       int group,
+                       const char* key,
+                       size_t length,
+                       BindingTarget& target);
+  typedef void (*Clear)(void* object, int group);
+
+  Kind kind_;
+  void* field_; // the member, or the struct of a group
+  // Members of objectField and groupField.
+  Find find_;
+  Clear clear_;
+  int group_; // rank of the group in Binding::describe(), from 1, or 0
+};
+
+template <typename T> struct BindingOps;
+
+/* Follows the groups of Binding::describe() while it runs, to tell whether
+ * the members being listed are within the group of rank group_ (0 for the
+ * whole struct).
+ */
+class BindingWalk {
+protected:
+  explicit BindingWalk(int group)
+      : group_(group), groups_(0), level_(group == 0 ? 0 : -1) {}
+
+  void enter() {
+    ++groups_;
+    if (level_ >= 0)
+      ++level_;
+    else if (groups_ == group_)
+      level_ = 0;
+  }
+
+  void leave() {
+    if (level_ >= 0)
+      --level_;
+  }
+
+  int group_;
+  int groups_; // groups entered so far
+  int level_;  // depth within the group, -1 outside of it
+};
+
+/// Finds the member of the group that a key names.
+class BindingMatcher : private BindingWalk {
+public:
+  BindingMatcher(int group,
+                 const char* key,
+                 size_t length,
+                 BindingTarget& target)
+      : BindingWalk(group), key_(key), length_(length), target_(target) {
+    target_.kind_ = BindingTarget::none;
+  }
+
+  template <size_t N> void beginGroup(const char (&name)[N]) {
+    bool matched = matches(name, N - 1);
+    enter();
+    if (matched) {
+      target_.kind_ = BindingTarget::groupField;
+      target_.group_ = groups_;
+    }
+  }
+
+  void endGroup() { leave(); }
+
+  template <size_t N> void field(const char (&name)[N], bool& value) {
+    set(name, N - 1, BindingTarget::boolField, &value);
+  }
+  template <size_t N> void field(const char (&name)[N], Int& value) {
+    set(name, N - 1, BindingTarget::intField, &value);
+  }
+  template <size_t N> void field(const char (&name)[N], UInt& value) {
+    set(name, N - 1, BindingTarget::uintField, &value);
+  }
+#if defined(JSON_HAS_INT64)
+  template <size_t N> void field(const char (&name)[N], Int64& value) {
+    set(name, N - 1, BindingTarget::int64Field, &value);
+  }
+  template <size_t N> void field(const char (&name)[N], UInt64& value) {
+    set(name, N - 1, BindingTarget::uint64Field, &value);
+  }
+#endif // if defined(JSON_HAS_INT64)
+  template <size_t N> void field(const char (&name)[N], double& value) {
+    set(name, N - 1, BindingTarget::doubleField, &value);
+  }
+  template <size_t N> void field(const char (&name)[N], std::string& value) {
+    set(name, N - 1, BindingTarget::stringField, &value);
+  }
+  template <size_t N, typename T> void field(const char (&name)[N], T& value) {
+    if (set(name, N - 1, BindingTarget::objectField, &value)) {
+      target_.find_ = &BindingOps<T>::find;
+      target_.clear_ = &BindingOps<T>::clear;
+      target_.group_ = 0;
+    }
+  }
+
+private:
+  bool matches(const char* name, size_t length) const {
+    return level_ == 0 && length == length_ &&
+           memcmp(name, key_, length) == 0;
+  }
+
+  bool set(const char* name,
+           size_t length,
+           BindingTarget::Kind kind,
+           void* field) {
+    if (!matches(name, length))
+      return false;
+    target_.kind_ = kind;
+    target_.field_ = field;
+    return true;
+  }
+
+  const char* key_;
+  size_t length_;
+  BindingTarget& target_;
+};
+
+/// Resets the members of a group to what a null value reads as.
+class BindingClearer : private BindingWalk {
+public:
+  explicit BindingClearer(int group) : BindingWalk(group) {}
+
+  template <size_t N> void beginGroup(const char (&)[N]) { enter(); }
+  void endGroup() { leave(); }
+
+  template <size_t N> void field(const char (&)[N], bool& value) {
+    if (level_ >= 0)
+      value = false;
+  }
+  template <size_t N> void field(const char (&)[N], Int& value) {
+    if (level_ >= 0)
+      value = 0;
+  }
+  template <size_t N> void field(const char (&)[N], UInt& value) {
+    if (level_ >= 0)
+      value = 0;
+  }
+#if defined(JSON_HAS_INT64)
+  template <size_t N> void field(const char (&)[N], Int64& value) {
+    if (level_ >= 0)
+      value = 0;
+  }
+  template <size_t N> void field(const char (&)[N], UInt64& value) {
+    if (level_ >= 0)
+      value = 0;
+  }
+#endif // if defined(JSON_HAS_INT64)
+  template <size_t N> void field(const char (&)[N], double& value) {
+    if (level_ >= 0)
+      value = 0.0;
+  }
+  template <size_t N> void field(const char (&)[N], std::string& value) {
+    if (level_ >= 0)
+      value.clear();
+  }
+  template <size_t N, typename T> void field(const char (&)[N], T& value) {
+    if (level_ >= 0)
+      BindingOps<T>::clear(&value, 0);
+  }
+};
+
+/// Selects the top-level members of a struct with SaxReader::addPath().
+class BindingPaths : private BindingWalk {
+public:
+  explicit BindingPaths(SaxReader& reader) : BindingWalk(0), reader_(reader) {}
+
+  template <size_t N> void beginGroup(const char (&name)[N]) {
+    if (level_ == 0)
+      add(name, N - 1);
+    enter();
+  }
+
+  void endGroup() { leave(); }
+
+  template <size_t N, typename T> void field(const char (&name)[N], T&) {
+    if (level_ == 0)
+      add(name, N - 1);
+  }
+
+private:
+  void add(const char* name, size_t length) {
+    std::string pointer(1, '/');
+    for (const char* end = name + length; name != end; ++name) {
+      if (*name == '~')
+        pointer += "~0";
+      else if (*name == '/')
+        pointer += "~1";
+      else
+        pointer += *name;
+    }
+    reader_.addPath(pointer);
+  }
+
+  SaxReader& reader_;
+};
+
+template <typename T> struct BindingOps {
+  static void find(void* object,
+                   int group,
+                   const char* key,
+                   size_t length,
+                   BindingTarget& target) {
+    BindingMatcher matcher(group, key, length, target);
+    Binding<T>::describe(matcher, *static_cast<T*>(object));
+  }
+
+  static void clear(void* object, int group) {
+    BindingClearer clearer(group);
+    Binding<T>::describe(clearer, *static_cast<T*>(object));
+  }
+};
+
+/** \brief Reads documents straight into structs that have a Binding.
+ *
+ * The values of the document are stored into the members of the struct as
+ * a SaxReader reports them, without building a Value. Members that are not
+ * in the Binding are skipped without being decoded (see
+ * SaxReader::addPath()). Values convert like the Value accessors do
+ * (asBool(), asInt(), asDouble(), asString()...), and the cases where those
+ * would throw fail the parse instead, as do arrays and scalars given for an
+ * object.
+ *
+ * Members missing from an object read as if they were null: numbers are
+ * set to 0, booleans to \c false, strings to "", and the members of nested
+ * objects likewise. An object given twice thus replaces the first one
+ * entirely, like in a Value.
+ *
+ * When the parse fails, the struct may have been partly read.
+ *
+ * Example of usage:
+ * \code
+ * Eye eye;
+ * Json::BindingReader reader;
+ * if (!reader.parseFile("eye.json", eye))
+ *   std::cerr << reader.getFormattedErrorMessages();
+ * \endcode
+ */
+class BindingReader : private SaxHandler {
+public:
+  BindingReader() {}
+  explicit BindingReader(const Features& features) : reader_(features) {}
+
+  /// Read the document in [\a begin, \a end) into \a object.
+  template <typename T>
+  bool parse(const char* begin, const char* end, T& object) {
+    start(object);
+    return reader_.parse(begin, end, *this, false) && reader_.good();
+  }
+
+  /// Read the file at \a path into \a object. \see SaxReader::parseFile()
+  template <typename T> bool parseFile(const std::string& path, T& object) {
+    start(object);
+    return reader_.parseFile(path, *this, false) && reader_.good();
+  }
+#if defined(_WIN32)
+  template <typename T> bool parseFile(const std::wstring& path, T& object) {
+    start(object);
+    return reader_.parseFile(path, *this, false) && reader_.good();
+  }
+#endif
+
+  /// \see Reader::getFormattedErrorMessages()
+  std::string getFormattedErrorMessages() const {
+    return reader_.getFormattedErrorMessages();
+  }
+
+private:
+  // disabled copy constructor and assignement operator.
+  BindingReader(const BindingReader&);
+  void operator=(const BindingReader&);
+
+  template <typename T> void start(T& object) {
+    reader_.clearPaths();
+    BindingPaths paths(reader_);
+    Binding<T>::describe(paths, object);
+    frames_.clear();
+    pending_.kind_ = BindingTarget::objectField;
+    pending_.field_ = &object;
+    pending_.find_ = &BindingOps<T>::find;
+    pending_.clear_ = &BindingOps<T>::clear;
+    pending_.group_ = 0;
+    skipped_ = 0;
+    failed_ = false;
+  }
+
+  template <typename T> T& pending() const {
+    return *static_cast<T*>(pending_.field_);
+  }
+
+  // A value to store, rather than one to skip or one after an error.
+  bool isPending() const {
+    return !failed_ && skipped_ == 0 && pending_.kind_ != BindingTarget::none;
+  }
+
+  bool isObject() const {
+    return pending_.kind_ == BindingTarget::objectField ||
+           pending_.kind_ == BindingTarget::groupField;
+  }
+
+  void fail(const char* message);
+  void failExpected();
+  void setInteger(LargestInt value);
+  void setInteger(LargestUInt value);
+
+  virtual void onNull();
+  virtual void onBool(bool value);
+  virtual void onInt(LargestInt value);
+  virtual void onUInt(LargestUInt value);
+  virtual void onDouble(double value);
+  virtual void onString(const char* begin, const char* end);
+  virtual void onObjectBegin();
+  virtual void onKey(const char* begin, const char* end);
+  virtual void onObjectEnd();
+  virtual void onArrayBegin();
+  virtual void onArrayEnd();
+
+  SaxReader reader_;
+  std::vector<BindingTarget> frames_; // objects being read
+  BindingTarget pending_;             // where the next value goes
+  int skipped_;                       // depth within a skipped value
+  bool failed_;
+};
+
+inline void BindingReader::fail(const char* message) {
+  Value location;
+  location.setOffsetStart(reader_.getOffsetStart());
+  location.setOffsetLimit(reader_.getOffsetLimit());
+  reader_.pushError(location, message);
+  failed_ = true;
+}
+
+inline void BindingReader::failExpected() {
+  switch (pending_.kind_) {
+  case BindingTarget::boolField:
+    fail("Expected a boolean");
+    break;
+  case BindingTarget::stringField:
+    fail("Expected a string");
+    break;
+  case BindingTarget::objectField:
+  case BindingTarget::groupField:
+    fail("Expected an object");
+    break;
+  default:
+    fail("Expected a number");
+    break;
+  }
+}
+
+inline void BindingReader::setInteger(LargestInt value) {
+  switch (pending_.kind_) {
+  case BindingTarget::boolField:
+    pending<bool>() = value != 0;
+    break;
+  case BindingTarget::intField:
+    if (value < Value::minInt || value > Value::maxInt)
+      fail("Number out of range");
+    else
+      pending<Int>() = Int(value);
+    break;
+  case BindingTarget::uintField:
+    if (value < 0 || LargestUInt(value) > Value::maxUInt)
+      fail("Number out of range");
+    else
+      pending<UInt>() = UInt(value);
+    break;
+#if defined(JSON_HAS_INT64)
+  case BindingTarget::int64Field:
+    pending<Int64>() = Int64(value);
+    break;
+  case BindingTarget::uint64Field:
+    if (value < 0)
+      fail("Number out of range");
+    else
+      pending<UInt64>() = UInt64(value);
+    break;
+#endif // if defined(JSON_HAS_INT64)
+  case BindingTarget::doubleField:
+    pending<double>() = double(value);
+    break;
+  case BindingTarget::stringField:
+    pending<std::string>() = valueToString(value);
+    break;
+  default:
+    failExpected();
+    break;
+  }
+}
+
+inline void BindingReader::setInteger(LargestUInt value) {
+  switch (pending_.kind_) {
+  case BindingTarget::boolField:
+    pending<bool>() = value != 0;
+    break;
+  case BindingTarget::intField:
+    if (value > LargestUInt(Value::maxInt))
+      fail("Number out of range");
+    else
+      pending<Int>() = Int(value);
+    break;
+  case BindingTarget::uintField:
+    if (value > Value::maxUInt)
+      fail("Number out of range");
+    else
+      pending<UInt>() = UInt(value);
+    break;
+#if defined(JSON_HAS_INT64)
+  case BindingTarget::int64Field:
+    if (value > LargestUInt(Value::maxInt64))
+      fail("Number out of range");
+    else
+      pending<Int64>() = Int64(value);
+    break;
+  case BindingTarget::uint64Field:
+    pending<UInt64>() = UInt64(value);
+    break;
+#endif // if defined(JSON_HAS_INT64)
+  case BindingTarget::doubleField:
+    pending<double>() = double(value);
+    break;
+  case BindingTarget::stringField:
+    pending<std::string>() = valueToString(value);
+    break;
+  default:
+    failExpected();
+    break;
+  }
+}
+
+inline void BindingReader::onNull() {
+  if (!isPending())
+    return;
+  if (isObject())
+    pending_.clear_(pending_.field_, pending_.group_);
+  else if (pending_.kind_ == BindingTarget::stringField)
+    pending<std::string>().clear();
+  else
+    setInteger(LargestInt(0));
+}
+
+inline void BindingReader::onBool(bool value) {
+  if (!isPending())
+    return;
+  if (pending_.kind_ == BindingTarget::stringField)
+    pending<std::string>() = value ? "true" : "false";
+  else
+    setInteger(LargestInt(value ? 1 : 0));
+}
+
+inline void BindingReader::onInt(LargestInt value) {
+  if (isPending())
+    setInteger(value);
+}
+
+inline void BindingReader::onUInt(LargestUInt value) {
+  if (isPending())
+    setInteger(value);
+}
+
+inline void BindingReader::onDouble(double value) {
+  if (!isPending())
+    return;
+  switch (pending_.kind_) {
+  case BindingTarget::boolField:
+    pending<bool>() = value != 0.0;
+    break;
+  case BindingTarget::intField:
+    if (!(value >= double(Value::minInt) && value <= double(Value::maxInt)))
+      fail("Number out of range");
+    else
+      pending<Int>() = Int(value);
+    break;
+  case BindingTarget::uintField:
+    if (!(value >= 0.0 && value <= double(Value::maxUInt)))
+      fail("Number out of range");
+    else
+      pending<UInt>() = UInt(value);
+    break;
+#if defined(JSON_HAS_INT64)
+  case BindingTarget::int64Field:
+    if (!(value >= double(Value::minInt64) &&
+          value <= double(Value::maxInt64)))
+      fail("Number out of range");
+    else
+      pending<Int64>() = Int64(value);
+    break;
+  case BindingTarget::uint64Field:
+    if (!(value >= 0.0 && value <= double(Value::maxUInt64)))
+      fail("Number out of range");
+    else
+      pending<UInt64>() = UInt64(value);
+    break;
+#endif // if defined(JSON_HAS_INT64)
+  case BindingTarget::doubleField:
+    pending<double>() = value;
+    break;
+  case BindingTarget::stringField:
+    pending<std::string>() = valueToString(value);
+    break;
+  default:
+    failExpected();
+    break;
+  }
+}
+
+inline void BindingReader::onString(const char* begin, const char* end) {
+  if (!isPending())
+    return;
+  if (pending_.kind_ == BindingTarget::stringField)
+    pending<std::string>().assign(begin, end);
+  else
+    failExpected();
+}
+
+inline void BindingReader::onObjectBegin() {
+  if (failed_)
+    return;
+  if (!isPending()) {
+    ++skipped_;
+    return;
+  }
+  if (!isObject()) {
+    failExpected();
+    return;
+  }
+  pending_.clear_(pending_.field_, pending_.group_);
+  frames_.push_back(pending_);
+  pending_.kind_ = BindingTarget::none;
+}
+
+inline void BindingReader::onKey(const char* begin, const char* end) {
+  if (failed_ || skipped_)
+    return;
+  const BindingTarget& object = frames_.back();
+  object.find_(object.field_, object.group_, begin, size_t(end - begin),
+               pending_);
+  if (pending_.kind_ == BindingTarget::groupField) {
+    // Members of a group belong to the struct of the enclosing object.
+    pending_.field_ = object.field_;
+    pending_.find_ = object.find_;
+    pending_.clear_ = object.clear_;
+  }
+}
+
+inline void BindingReader::onObjectEnd() {
+  if (failed_)
+    return;
+  if (skipped_)
+    --skipped_;
+  else
+    frames_.pop_back();
+}
+
+inline void BindingReader::onArrayBegin() {
+  if (failed_)
+    return;
+  if (isPending())
+    failExpected();
+  else
+    ++skipped_;
+}
+
+inline void BindingReader::onArrayEnd() {
+  if (!failed_ && skipped_)
+    --skipped_;
+}
+
+/// Writes the members of a bound struct to a StreamingWriter.
+class BindingWriter {
+public:
+  explicit BindingWriter(StreamingWriter& writer) : writer_(writer) {}
+
+  template <size_t N> void beginGroup(const char (&name)[N]) {
+    writer_.key(name, name + N - 1);
+    writer_.beginObject();
+  }
+
+  void endGroup() { writer_.endObject(); }
+
+  template <size_t N, typename T>
+  void field(const char (&name)[N], const T& value) {
+    writer_.key(name, name + N - 1);
+    write(value);
+  }
+
+  /// Writes \a object as a JSON object.
+  template <typename T> void write(const T& object) {
+    writer_.beginObject();
+    Binding<T>::describe(*this, object);
+    writer_.endObject();
+  }
+
+private:
+  void write(bool value) { writer_.value(value); }
+  void write(Int value) { writer_.value(value); }
+  void write(UInt value) { writer_.value(value); }
+#if defined(JSON_HAS_INT64)
+  void write(Int64 value) { writer_.value(value); }
+  void write(UInt64 value) { writer_.value(value); }
+#endif // if defined(JSON_HAS_INT64)
+  void write(double value) { writer_.value(value); }
+  void write(const std::string& value) { writer_.value(value); }
+
+  StreamingWriter& writer_;
+};
+
+/// Writes \a object, described by Binding<T>, as a JSON object.
+template <typename T>
+inline void writeObject(StreamingWriter& writer, const T& object) {
+  BindingWriter(writer).write(object);
+}
+
+} // namespace Json
+
+#endif // CPPTL_JSON_BINDING_H_INCLUDED
@@ -15,6 +15,25 @@
 /// std::map
 /// as Value container.
 //#  define JSON_USE_CPPTL_SMALLMAP 1
+/// If defined, indicates that a sorted array with a hash index for large
+/// objects (see FlatMap) should be used instead of std::map as Value
+/// container.
+//#  define JSON_USE_FLAT_MAP 1
+/// If defined, Value only holds its payload and type in 16 bytes, and keeps
+/// comments and source offsets in a side table. Strings and member names
+/// are then only stored inline up to 7 characters, and the Reader only
+/// records offsets when collecting comments.
+//#  define JSON_COMPACT_VALUE 1
+/// If defined, copying a Value shares its arrays and objects with the copy
+/// until either of them modifies one (copy on write). Shared values can be
+/// read from several threads, and copied or modified from several threads
+/// as long as each modifies its own copy. References and iterators obtained
+/// from a non-const Value must not be used to modify it once it has been
+/// copied: get them again. Not available with JSON_VALUE_USE_INTERNAL_MAP.
+//#  define JSON_COPY_ON_WRITE 1
+#if defined(JSON_COPY_ON_WRITE) && defined(JSON_VALUE_USE_INTERNAL_MAP)
+#undef JSON_COPY_ON_WRITE
+#endif
 /// If defined, indicates that Json specific container should be used
 /// (hash table & simple deque container with customizable allocator).
 /// THIS FEATURE IS STILL EXPERIMENTAL! There is know bugs: See #3177332
@@ -87,6 +106,38 @@
 #define JSONCPP_DEPRECATED(message)
 #endif // if !defined(JSONCPP_DEPRECATED)
 
+// If JSON_HAS_STD_THREAD is 1, BatchReader parses documents on several
+// threads. Define it to 0 to always parse them on the calling thread.
+#if !defined(JSON_HAS_STD_THREAD)
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700)
+#define JSON_HAS_STD_THREAD 1
+#else
+#define JSON_HAS_STD_THREAD 0
+#endif
+#endif // if !defined(JSON_HAS_STD_THREAD)
+
+// If JSON_HAS_THREAD_LOCAL is 1, ThreadLocalPoolResource caches freed blocks
+// per thread. Define it to 0 if the compiler does not support thread_local.
+#if !defined(JSON_HAS_THREAD_LOCAL)
+#if !JSON_HAS_STD_THREAD
+#define JSON_HAS_THREAD_LOCAL 0
+#elif __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define JSON_HAS_THREAD_LOCAL 1
+#else
+#define JSON_HAS_THREAD_LOCAL 0
+#endif
+#endif // if !defined(JSON_HAS_THREAD_LOCAL)
+
+// If JSON_HAS_RVALUE_REFERENCES is 1, Value can be moved instead of deep
+// copied (Value(Value&&), append(Value&&)).
+#if !defined(JSON_HAS_RVALUE_REFERENCES)
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#define JSON_HAS_RVALUE_REFERENCES 1
+#else
+#define JSON_HAS_RVALUE_REFERENCES 0
+#endif
+#endif // if !defined(JSON_HAS_RVALUE_REFERENCES)
+
 namespace Json {
 typedef int Int;
 typedef unsigned int UInt;
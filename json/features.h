@@ -30,7 +30,7 @@ public:
    * specification.
    * - Comments are forbidden.
    * - Root object must be either an array or an object value.
-   * - Assumes Value strings are encoded in UTF-8
+   * - Strings must be valid UTF-8
    */
   static Features strictMode();
 
@@ -50,6 +50,11 @@ public:
 
   /// \c true if numeric object key are allowed. Default: \c false.
   bool allowNumericKeys_;
+
+  /// \c true if strings must be valid UTF-8: no overlong or truncated
+  /// sequences, no surrogates, and no unpaired surrogate in \\u escape
+  /// sequences. Default: \c false.
+  bool validateUTF8_;
 };
 
 } // namespace Json
@@ -0,0 +1,135 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_FLATARRAY_H_INCLUDED
+#define CPPTL_JSON_FLATARRAY_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "config.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstddef>
+#include <new>
+
+namespace Json {
+
+/** \brief Contiguous array of elements, used as Value::ArrayValues.
+ *
+ * Like std::vector, with O(1) indexing and amortized O(1) append, but
+ * elements are moved to a larger block by swapping them with default
+ * constructed ones, so that growing an array of Value never deep copies
+ * its elements. \a T must be default constructible and provide swap().
+ *
+ * Iterators are plain pointers, invalidated when the array grows.
+ */
+template <typename T, typename Allocator> class FlatArray {
+public:
+  typedef T value_type;
+  typedef Allocator allocator_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+  typedef size_t size_type;
+
+  explicit FlatArray(const allocator_type& allocator = allocator_type())
+      : allocator_(allocator), elements_(0), size_(0), capacity_(0) {}
+
+  ~FlatArray() {
+    clear();
+    if (elements_)
+      allocator_.deallocate(elements_, capacity_);
+  }
+
+  allocator_type get_allocator() const { return allocator_; }
+
+  iterator begin() { return elements_; }
+  const_iterator begin() const { return elements_; }
+  iterator end() { return elements_ + size_; }
+  const_iterator end() const { return elements_ + size_; }
+
+  size_type size() const { return size_; }
+  size_type capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  T& operator[](size_type index) { return elements_[index]; }
+  const T& operator[](size_type index) const { return elements_[index]; }
+
+  void reserve(size_type count) {
+    if (count > capacity_)
+      reallocate(count);
+  }
+
+  /// Appends a default constructed element.
+  T& append() {
+    if (size_ == capacity_)
+      reallocate(capacity_ ? capacity_ * 2 : 4);
+    new (elements_ + size_) T();
+    return elements_[size_++];
+  }
+
+  /// Appends a copy of \a value, which may be an element of this array.
+  T& push_back(const T& value) {
+    if (size_ != capacity_) {
+      new (elements_ + size_) T(value);
+    } else {
+      // Copied before the elements move, in case value is one of them.
+      size_type capacity = capacity_ ? capacity_ * 2 : 4;
+      T* elements = allocator_.allocate(capacity);
+      new (elements + size_) T(value);
+      relocate(elements, capacity);
+    }
+    return elements_[size_++];
+  }
+
+  /// Appends default constructed elements or removes the last ones.
+  void resize(size_type count) {
+    if (count > capacity_)
+      reallocate(count);
+    while (size_ < count)
+      new (elements_ + size_++) T();
+    while (size_ > count)
+      elements_[--size_].~T();
+  }
+
+  void erase(iterator position) {
+    for (T* element = position; element + 1 != end(); ++element)
+      element->swap(element[1]);
+    elements_[--size_].~T();
+  }
+
+  /// Removes all elements. The memory is kept for the next insertions.
+  void clear() {
+    while (size_ != 0)
+      elements_[--size_].~T();
+  }
+
+private:
+  // disabled copy constructor and assignement operator.
+  FlatArray(const FlatArray&);
+  void operator=(const FlatArray&);
+
+  void reallocate(size_type capacity) {
+    relocate(allocator_.allocate(capacity), capacity);
+  }
+
+  void relocate(T* elements, size_type capacity) {
+    for (size_type index = 0; index != size_; ++index) {
+      new (elements + index) T();
+      elements[index].swap(elements_[index]);
+      elements_[index].~T();
+    }
+    if (elements_)
+      allocator_.deallocate(elements_, capacity_);
+    elements_ = elements;
+    capacity_ = capacity;
+  }
+
+  allocator_type allocator_;
+  T* elements_;
+  size_type size_;
+  size_type capacity_;
+};
+
+} // namespace Json
+
+#endif // CPPTL_JSON_FLATARRAY_H_INCLUDED
@@ -0,0 +1,429 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_FLATMAP_H_INCLUDED
+#define CPPTL_JSON_FLATMAP_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "config.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Json {
+
+/** \brief Sorted associative container stored in a single array.
+ *
+ * Used as Value::ObjectValues instead of std::map when JSON_USE_FLAT_MAP is
+ * defined (see config.h). Members are kept sorted by key in one contiguous
+ * block, so iteration visits them in the same order as std::map, and a
+ * whole object costs one allocation instead of one per member.
+ *
+ * Maps of up to linearSearchLimit members, which covers most JSON objects,
+ * are searched linearly. Larger ones keep an open addressing hash index of
+ * the positions of their members, so that lookups stay O(1).
+ *
+ * Inserting a member before others moves them, so building a map in
+ * descending order costs O(n^2). Parsers, which can not choose the order,
+ * use push_back() and sort() instead.
+ *
+ * Only the part of the std::map interface used by Value is provided.
+ * Iterators are plain pointers: unlike those of std::map, they are
+ * invalidated by insertions and removals.
+ *
+ * \a Key must be default constructible and provide swap() and hash(); \a T
+ * must be default constructible and provide swap(). Elements are moved
+ * around by swapping them with default constructed ones.
+ */
+template <typename Key, typename T, typename Allocator> class FlatMap {
+public:
+  typedef Key key_type;
+  typedef T mapped_type;
+  typedef std::pair<Key, T> value_type;
+  typedef std::less<Key> key_compare;
+  typedef Allocator allocator_type;
+  typedef value_type* iterator;
+  typedef const value_type* const_iterator;
+  typedef size_t size_type;
+
+  /// Maps up to that size are searched without hash index.
+  enum { linearSearchLimit = 8 };
+
+  explicit FlatMap(const key_compare& = key_compare(),
+                   const allocator_type& allocator = allocator_type())
+      : allocator_(allocator), entries_(0), size_(0), capacity_(0), slots_(0),
+        slotMask_(0) {}
+
+  FlatMap(const FlatMap& other)
+      : allocator_(other.allocator_), entries_(0), size_(0), capacity_(0),
+        slots_(0), slotMask_(0) {
+    if (other.size_ == 0)
+      return;
+    entries_ = allocator_.allocate(other.size_);
+    capacity_ = other.size_;
+    for (; size_ != other.size_; ++size_)
+      new (entries_ + size_) value_type(other.entries_[size_]);
+    if (other.slots_) {
+      slots_ = SlotAllocator(allocator_).allocate(other.slotMask_ + 1);
+      slotMask_ = other.slotMask_;
+      memcpy(slots_, other.slots_, (slotMask_ + 1) * sizeof(Slot));
+    }
+  }
+
+  ~FlatMap() {
+    clear();
+    if (entries_)
+      allocator_.deallocate(entries_, capacity_);
+  }
+
+  FlatMap& operator=(FlatMap other) {
+    swap(other);
+    return *this;
+  }
+
+  void swap(FlatMap& other) {
+    std::swap(allocator_, other.allocator_);
+    std::swap(entries_, other.entries_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(slots_, other.slots_);
+    std::swap(slotMask_, other.slotMask_);
+  }
+
+  allocator_type get_allocator() const { return allocator_; }
+
+  iterator begin() { return entries_; }
+  const_iterator begin() const { return entries_; }
+  iterator end() { return entries_ + size_; }
+  const_iterator end() const { return entries_ + size_; }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /// Removes all elements. The memory is kept for the next insertions.
+  void clear() {
+    while (size_ != 0)
+      entries_[--size_].~value_type();
+    releaseIndex();
+  }
+
+  void reserve(size_type count) {
+    if (count > capacity_)
+      reallocate(count);
+  }
+
+  iterator find(const key_type& key) { return entries_ + findPosition(key); }
+  const_iterator find(const key_type& key) const {
+    return entries_ + findPosition(key);
+  }
+
+  iterator lower_bound(const key_type& key) {
+    return entries_ + lowerBoundPosition(key);
+  }
+  const_iterator lower_bound(const key_type& key) const {
+    return entries_ + lowerBoundPosition(key);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    size_type position = lowerBoundPosition(value.first);
+    if (position != size_ && entries_[position].first == value.first)
+      return std::pair<iterator, bool>(entries_ + position, false);
+    return std::pair<iterator, bool>(insertAt(position, value), true);
+  }
+
+  /// Inserts \a value before \a hint if that keeps the map sorted, as
+  /// lower_bound() returns, else like insert(const value_type&).
+  iterator insert(iterator hint, const value_type& value) {
+    size_type position = size_type(hint - entries_);
+    if ((position == 0 || entries_[position - 1].first < value.first) &&
+        (position == size_ || value.first < entries_[position].first))
+      return insertAt(position, value);
+    return insert(value).first;
+  }
+
+  void erase(iterator position) { eraseAt(size_type(position - entries_)); }
+
+  size_type erase(const key_type& key) {
+    size_type position = findPosition(key);
+    if (position == size_)
+      return 0;
+    eraseAt(position);
+    return 1;
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    size_type position = lowerBoundPosition(key);
+    if (position == size_ || !(entries_[position].first == key))
+      insertAt(position, value_type(key, mapped_type()));
+    return entries_[position].second;
+  }
+
+  /// Appends \a value, whose key must not be in the map yet, whatever its
+  /// order, in O(1). Until sort() is called, the map may only be searched
+  /// with find(), iterated in that unsorted order and appended to.
+  iterator push_back(const value_type& value) { return insertAt(size_, value); }
+
+  /// Restores the order of the elements after push_back(), in O(n log n).
+  void sort() {
+    size_type position = 1;
+    while (position < size_ &&
+           entries_[position - 1].first < entries_[position].first)
+      ++position;
+    if (position >= size_)
+      return;
+    if (!slots_) {
+      // Few elements: insertion sort in place.
+      for (; position != size_; ++position) {
+        for (size_type index = position;
+             index != 0 && entries_[index].first < entries_[index - 1].first;
+             --index)
+          swapEntries(entries_[index], entries_[index - 1]);
+      }
+      return;
+    }
+    // Sort the positions, then move each element once along the cycles of
+    // that permutation: order[index] is where the element to put at index
+    // is.
+    std::vector<size_type> order(size_);
+    for (size_type index = 0; index != size_; ++index)
+      order[index] = index;
+    std::sort(order.begin(), order.end(), PositionLess(entries_));
+    for (size_type first = 0; first != size_; ++first) {
+      size_type index = first;
+      while (order[index] != first) {
+        size_type next = order[index];
+        swapEntries(entries_[index], entries_[next]);
+        order[index] = index;
+        index = next;
+      }
+      order[index] = index;
+    }
+    memset(slots_, 0, (slotMask_ + 1) * sizeof(Slot));
+    for (size_type index = 0; index != size_; ++index)
+      addSlot(entries_[index].first.hash(), index);
+  }
+
+private:
+  /// Hash index entry. position_ is the position of the element plus one,
+  /// 0 for an empty slot.
+  struct Slot {
+    unsigned int hash_;
+    unsigned int position_;
+  };
+  typedef typename allocator_type::template rebind<Slot>::other SlotAllocator;
+
+  static void swapEntries(value_type& a, value_type& b) {
+    a.first.swap(b.first);
+    a.second.swap(b.second);
+  }
+
+  /// Orders positions by the keys of the elements there.
+  struct PositionLess {
+    explicit PositionLess(const value_type* entries) : entries_(entries) {}
+    bool operator()(size_type a, size_type b) const {
+      return entries_[a].first < entries_[b].first;
+    }
+    const value_type* entries_;
+  };
+
+  size_type findPosition(const key_type& key) const {
+    if (slots_) {
+      unsigned int hash = key.hash();
+      for (size_type slot = hash & slotMask_; slots_[slot].position_;
+           slot = (slot + 1) & slotMask_) {
+        size_type position = slots_[slot].position_ - 1;
+        if (slots_[slot].hash_ == hash && entries_[position].first == key)
+          return position;
+      }
+      return size_;
+    }
+    for (size_type position = 0; position != size_; ++position) {
+      if (entries_[position].first == key)
+        return position;
+    }
+    return size_;
+  }
+
+  size_type lowerBoundPosition(const key_type& key) const {
+    // Members are often inserted in order, and array elements always are.
+    if (size_ == 0 || entries_[size_ - 1].first < key)
+      return size_;
+    if (!slots_) {
+      size_type position = 0;
+      while (entries_[position].first < key)
+        ++position;
+      return position;
+    }
+    size_type position = findPosition(key);
+    if (position != size_)
+      return position;
+    size_type first = 0;
+    size_type count = size_;
+    while (count != 0) {
+      size_type half = count / 2;
+      if (entries_[first + half].first < key) {
+        first += half + 1;
+        count -= half + 1;
+      } else {
+        count = half;
+      }
+    }
+    return first;
+  }
+
+  iterator insertAt(size_type position, const value_type& value) {
+    if (size_ == capacity_)
+      reallocate(capacity_ ? capacity_ * 2 : 4);
+    new (entries_ + size_) value_type(value);
+    for (size_type index = size_; index != position; --index)
+      swapEntries(entries_[index], entries_[index - 1]);
+    ++size_;
+
+    if (slots_) {
+      if (size_ * 2 > slotMask_ + 1)
+        rehash((slotMask_ + 1) * 2);
+      if (position != size_ - 1)
+        shiftPositions(position, 1);
+      addSlot(entries_[position].first.hash(), position);
+    } else if (size_ > linearSearchLimit) {
+      buildIndex();
+    }
+    return entries_ + position;
+  }
+
+  void eraseAt(size_type position) {
+    if (slots_) {
+      removeSlot(entries_[position].first.hash(), position);
+      if (position != size_ - 1)
+        shiftPositions(position + 1, size_type(-1));
+    }
+    for (size_type index = position; index + 1 != size_; ++index)
+      swapEntries(entries_[index], entries_[index + 1]);
+    entries_[--size_].~value_type();
+  }
+
+  void reallocate(size_type capacity) {
+    value_type* entries = allocator_.allocate(capacity);
+    for (size_type index = 0; index != size_; ++index) {
+      new (entries + index) value_type();
+      swapEntries(entries[index], entries_[index]);
+      entries_[index].~value_type();
+    }
+    if (entries_)
+      allocator_.deallocate(entries_, capacity_);
+    entries_ = entries;
+    capacity_ = capacity;
+  }
+
+  void buildIndex() {
+    size_type slotCount = 32;
+    while (slotCount < size_ * 2)
+      slotCount *= 2;
+    allocateSlots(slotCount);
+    for (size_type position = 0; position != size_; ++position)
+      addSlot(entries_[position].first.hash(), position);
+  }
+
+  void rehash(size_type slotCount) {
+    Slot* slots = slots_;
+    size_type oldCount = slotMask_ + 1;
+    allocateSlots(slotCount);
+    for (size_type slot = 0; slot != oldCount; ++slot) {
+      if (slots[slot].position_)
+        addSlot(slots[slot].hash_, slots[slot].position_ - 1);
+    }
+    SlotAllocator(allocator_).deallocate(slots, oldCount);
+  }
+
+  void allocateSlots(size_type slotCount) {
+    slots_ = SlotAllocator(allocator_).allocate(slotCount);
+    memset(slots_, 0, slotCount * sizeof(Slot));
+    slotMask_ = slotCount - 1;
+  }
+
+  void releaseIndex() {
+    if (slots_)
+      SlotAllocator(allocator_).deallocate(slots_, slotMask_ + 1);
+    slots_ = 0;
+    slotMask_ = 0;
+  }
+
+  void addSlot(unsigned int hash, size_type position) {
+    size_type slot = hash & slotMask_;
+    while (slots_[slot].position_)
+      slot = (slot + 1) & slotMask_;
+    slots_[slot].hash_ = hash;
+    slots_[slot].position_ = static_cast<unsigned int>(position + 1);
+  }
+
+  // Backward shift deletion: following slots of the same run are moved up,
+  // unless that would put them before their home slot.
+  void removeSlot(unsigned int hash, size_type position) {
+    size_type hole = hash & slotMask_;
+    while (slots_[hole].position_ != position + 1)
+      hole = (hole + 1) & slotMask_;
+    for (size_type slot = (hole + 1) & slotMask_; slots_[slot].position_;
+         slot = (slot + 1) & slotMask_) {
+      size_type home = slots_[slot].hash_ & slotMask_;
+      if (((slot - home) & slotMask_) >= ((slot - hole) & slotMask_)) {
+        slots_[hole] = slots_[slot];
+        hole = slot;
+      }
+    }
+    slots_[hole].position_ = 0;
+  }
+
+  /// Adds \a delta to the positions from \a first on.
+  void shiftPositions(size_type first, size_type delta) {
+    for (size_type slot = 0; slot <= slotMask_; ++slot) {
+      if (slots_[slot].position_ > first)
+        slots_[slot].position_ += static_cast<unsigned int>(delta);
+    }
+  }
+
+  allocator_type allocator_;
+  value_type* entries_;
+  size_type size_;
+  size_type capacity_;
+  Slot* slots_;
+  size_type slotMask_;
+};
+
+template <typename Key, typename T, typename Allocator>
+bool operator==(const FlatMap<Key, T, Allocator>& a,
+                const FlatMap<Key, T, Allocator>& b) {
+  if (a.size() != b.size())
+    return false;
+  typename FlatMap<Key, T, Allocator>::const_iterator it = a.begin();
+  typename FlatMap<Key, T, Allocator>::const_iterator other = b.begin();
+  for (; it != a.end(); ++it, ++other) {
+    if (!(it->first == other->first) || !(it->second == other->second))
+      return false;
+  }
+  return true;
+}
+
+template <typename Key, typename T, typename Allocator>
+bool operator<(const FlatMap<Key, T, Allocator>& a,
+               const FlatMap<Key, T, Allocator>& b) {
+  typename FlatMap<Key, T, Allocator>::const_iterator it = a.begin();
+  typename FlatMap<Key, T, Allocator>::const_iterator other = b.begin();
+  for (; it != a.end() && other != b.end(); ++it, ++other) {
+    if (*it < *other)
+      return true;
+    if (*other < *it)
+      return false;
+  }
+  return it == a.end() && other != b.end();
+}
+
+} // namespace Json
+
+#endif // CPPTL_JSON_FLATMAP_H_INCLUDED
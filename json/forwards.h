@@ -15,13 +15,24 @@ namespace Json {
 // writer.h
 class FastWriter;
 class StyledWriter;
+class Formatter;
+
+// sink.h
+class OutputSink;
 
 // reader.h
 class Reader;
+class LazyDocument;
+class LazyValue;
+class BatchReader;
 
 // features.h
 class Features;
 
+class MemoryResource;
+class ValueArena;
+class KeyTable;
+
 // value.h
 typedef unsigned int ArrayIndex;
 class StaticString;
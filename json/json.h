@@ -8,8 +8,12 @@
 
 #include "autolink.h"
 #include "value.h"
+#include "keytable.h"
 #include "reader.h"
+#include "lazy.h"
+#include "batch.h"
 #include "writer.h"
+#include "binding.h"
 #include "features.h"
 
 #endif // JSON_JSON_H_INCLUDED
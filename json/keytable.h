@@ -0,0 +1,62 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_KEYTABLE_H_INCLUDED
+#define CPPTL_JSON_KEYTABLE_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "config.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstddef>
+
+namespace Json {
+
+/** \brief Table of interned object member names.
+ *
+ * intern() returns the same immutable copy for equal names, so that the
+ * members of many objects that share a name share one allocation, and
+ * comparing two interned names only compares pointers. Reader::setKeyTable()
+ * interns the member names of parsed documents, which stores them in the
+ * tree as StaticString names: they are never duplicated, even when the
+ * Value is copied.
+ *
+ * Interned names live as long as the table. Use one table per set of
+ * documents with a bounded lifetime, or shared() for names that stay in
+ * use until the process exits (shared() is never destroyed, so it should
+ * not intern names from untrusted documents).
+ *
+ * intern() is thread-safe when the library is built with C++11 threads
+ * (see JSON_HAS_STD_THREAD).
+ */
+class JSON_API KeyTable {
+public:
+  KeyTable();
+  ~KeyTable();
+
+  /// Table for the whole process, never destroyed.
+  static KeyTable& shared();
+
+  /// Null terminated copy of [\a begin, \a begin + \a length), the same
+  /// for all equal names.
+  const char* intern(const char* begin, size_t length);
+  /// Same as intern(const char*, size_t) for a null terminated name.
+  const char* intern(const char* name);
+
+  /// Number of distinct names.
+  size_t size() const;
+
+private:
+  struct Impl;
+
+  // disabled copy constructor and assignement operator.
+  KeyTable(const KeyTable&);
+  void operator=(const KeyTable&);
+
+  Impl* impl_;
+};
+
+} // namespace Json
+
+#endif // CPPTL_JSON_KEYTABLE_H_INCLUDED
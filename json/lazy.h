@@ -0,0 +1,256 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_LAZY_H_INCLUDED
+#define CPPTL_JSON_LAZY_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "reader.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <string>
+#include <vector>
+
+// Disable warning C4251: <data member>: <type> needs to have dll-interface to
+// be used by...
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif // if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+
+namespace Json {
+
+/** \brief Read-only view of a value of a LazyDocument.
+ *
+ * A LazyValue is a small handle on the tape of its document: navigating
+ * with operator[] does not allocate anything. Scalars are converted on
+ * access, with the same rules as the corresponding Value members, and
+ * materialize() builds a Value for a whole subtree when one is needed.
+ *
+ * Missing members and out of range indexes give a null LazyValue, like
+ * the const accessors of Value. A LazyValue is only valid as long as its
+ * document is alive and has not been parsed again.
+ */
+class JSON_API LazyValue {
+public:
+  /// A null value that does not belong to any document.
+  LazyValue();
+
+  ValueType type() const;
+
+  bool isNull() const;
+  bool isBool() const;
+  bool isNumeric() const;
+  bool isString() const;
+  bool isArray() const;
+  bool isObject() const;
+
+  std::string asString() const;
+  Int asInt() const;
+  UInt asUInt() const;
+#if defined(JSON_HAS_INT64)
+  Int64 asInt64() const;
+  UInt64 asUInt64() const;
+#endif // if defined(JSON_HAS_INT64)
+  LargestInt asLargestInt() const;
+  LargestUInt asLargestUInt() const;
+  float asFloat() const;
+  double asDouble() const;
+  bool asBool() const;
+
+  /// Number of values in array or object. Members of an object that share
+  /// the same name are each counted, while Value only keeps the last one.
+  ArrayIndex size() const;
+
+  /// \brief Return true if empty array, empty object, or null;
+  /// otherwise, false.
+  bool empty() const;
+
+  /** \brief Access an array element (zero based index).
+   * Elements are found by skipping over the previous ones, in time linear
+   * in \a index: prefer materialize() to visit every element of a large
+   * array.
+   */
+  LazyValue operator[](ArrayIndex index) const;
+  /// Same as operator[](ArrayIndex).
+  LazyValue operator[](int index) const;
+
+  /// Access an object member by name, null if there is no such member.
+  /// When a name appears several times, the last member wins, like Reader.
+  LazyValue operator[](const char* key) const;
+  /// Same as operator[](const char*).
+  LazyValue operator[](const std::string& key) const;
+
+  /// Return true if the object has a member named key.
+  bool isMember(const char* key) const;
+  /// Same as isMember(const char*).
+  bool isMember(const std::string& key) const;
+
+  /// \brief Return a list of the member names, sorted and without
+  /// duplicates.
+  ///
+  /// If null, return an empty list.
+  /// \pre type() is objectValue or nullValue
+  /// \post if type() was nullValue, it remains nullValue
+  Value::Members getMemberNames() const;
+
+  /** \brief Build the Value for this subtree.
+   * The result is the same as parsing the subtree with Reader and
+   * collectComments set to \c false, except that offsets are not set.
+   */
+  Value materialize() const;
+
+private:
+  friend class LazyDocument;
+
+  LazyValue(const LazyDocument* document, size_t index);
+
+  Value scalar() const;
+  size_t find(const char* key, size_t length) const;
+
+  const LazyDocument* document_;
+  size_t index_;
+};
+
+/** \brief A <a HREF="http://www.json.org">JSON</a> document parsed into a
+ * compact tape, whose values are only decoded when they are accessed.
+ *
+ * Parsing is done in two stages. The first one tokenizes the whole document
+ * into a flat array of 16 bytes nodes (the "tape"), one per value or member
+ * name, in document order. Containers record the index just past their last
+ * node so that they can be skipped in constant time, and strings refer to
+ * the document text instead of being copied (only strings with escape
+ * sequences are decoded into a shared buffer).
+ *
+ * The second stage happens on access, through the LazyValue returned by
+ * root(): lookups walk the tape, and a Value is only built for the subtrees
+ * passed to LazyValue::materialize(). A consumer that reads a few members of
+ * a large document never pays for the std::map nodes and strings of the
+ * rest of it.
+ *
+ * Comments are not kept.
+ *
+ * Example of usage:
+ * \code
+ * Json::LazyDocument document;
+ * if (!document.parseFile("osvr_user_settings.json"))
+ *   std::cerr << document.getFormattedErrorMessages();
+ * Json::LazyValue eyes = document.root()["personalSettings"]["eyes"];
+ * double ipd = eyes["left"]["pupilDistance"].asDouble();
+ * \endcode
+ */
+class JSON_API LazyDocument : private SaxHandler {
+public:
+  typedef SaxReader::StructuredError StructuredError;
+
+  /** \brief Constructs a LazyDocument allowing all features
+   * for parsing.
+   */
+  LazyDocument();
+
+  /** \brief Constructs a LazyDocument allowing the specified feature set
+   * for parsing.
+   */
+  LazyDocument(const Features& features);
+
+  /** \brief Parse a document held by the caller.
+   * The document is not copied: the range must stay valid, and unchanged,
+   * as long as values of this document are used.
+   * \return \c true if the document was successfully parsed, \c false if an
+   * error occurred.
+   */
+  bool parse(const char* beginDoc, const char* endDoc);
+
+  /// Same as parse(const char*, const char*), on a copy of \a document kept
+  /// by the LazyDocument.
+  bool parse(const std::string& document);
+
+  /// \brief Parse from input stream.
+  bool parse(std::istream& is);
+
+  /** \brief Parse a file over a read-only memory mapping of it.
+   * The mapping is kept until the next call to parseFile() or the
+   * destruction of the document.
+   * \return \c true if the document was successfully parsed, \c false if the
+   * file could not be opened or an error occurred.
+   */
+  bool parseFile(const std::string& path);
+#if defined(_WIN32)
+  /// Same as parseFile(const std::string&), for wide character paths.
+  bool parseFile(const std::wstring& path);
+#endif
+
+  /// Root value of the document, null if the last parse failed.
+  LazyValue root() const;
+
+  /// \see Reader::getFormattedErrorMessages()
+  std::string getFormattedErrorMessages() const;
+
+  /// \see Reader::getStructuredErrors()
+  std::vector<StructuredError> getStructuredErrors() const;
+
+  /// \see Reader::good()
+  bool good() const;
+
+private:
+  friend class LazyValue;
+
+  /// Type of a tape node holding an object member name.
+  enum { keyNode = objectValue + 1 };
+
+  struct Node {
+    unsigned char type_; ///< ValueType, or keyNode
+    bool pooled_;        ///< text is in pool_ rather than in the document
+    ArrayIndex size_;    ///< text length, or number of elements / members
+    union {
+      LargestInt int_;
+      LargestUInt uint_;
+      double real_;
+      bool bool_;
+      size_t text_; ///< offset of the text in the document or in pool_
+      size_t next_; ///< containers: index just past their last node
+    } value_;
+  };
+
+  // disabled copy constructor and assignement operator.
+  LazyDocument(const LazyDocument&);
+  void operator=(const LazyDocument&);
+
+  // SaxHandler callbacks, building the tape.
+  virtual void onNull();
+  virtual void onBool(bool value);
+  virtual void onInt(LargestInt value);
+  virtual void onUInt(LargestUInt value);
+  virtual void onDouble(double value);
+  virtual void onString(const char* begin, const char* end);
+  virtual void onObjectBegin();
+  virtual void onKey(const char* begin, const char* end);
+  virtual void onObjectEnd();
+  virtual void onArrayBegin();
+  virtual void onArrayEnd();
+
+  void clear();
+  bool endDocument(bool successful);
+  Node& addValue(ValueType type);
+  void setText(Node& node, const char* begin, const char* end);
+  void beginContainer(ValueType type);
+  void endContainer();
+
+  const char* text(const Node& node) const;
+  size_t skip(size_t index) const;
+  void materialize(size_t index, Value& value) const;
+
+  SaxReader sax_;
+  std::string pool_;
+  std::vector<Node> tape_;
+  std::vector<size_t> open_;
+};
+
+} // namespace Json
+
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(pop)
+#endif // if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+
+#endif // CPPTL_JSON_LAZY_H_INCLUDED
@@ -25,11 +25,124 @@
 
 namespace Json {
 
-/** \brief Unserialize a <a HREF="http://www.json.org">JSON</a> document into a
- *Value.
+/** \brief Read-only memory mapping of a whole file.
+ *
+ * The mapped bytes can be handed to Reader::parse(const char*, const char*,
+ * Value&, bool) as a borrowed range, so the document is never copied into an
+ * intermediate buffer. The range stays valid until close() is called or the
+ * MappedFile is destroyed.
+ *
+ * Example of usage:
+ * \code
+ * Json::MappedFile file;
+ * Json::Reader reader;
+ * Json::Value root;
+ * if (file.open("settings.json") &&
+ *     reader.parse(file.begin(), file.end(), root))
+ *   ...
+ * \endcode
+ */
+class JSON_API MappedFile {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  /// Map the file at \a path, releasing any previous mapping.
+  /// \return \c true if the file could be opened and mapped.
+  bool open(const char* path);
+#if defined(_WIN32)
+  /// Same as open(const char*), for wide character paths.
+  bool open(const wchar_t* path);
+#endif
+  /// Release the mapping. Pointers returned by begin() and end() are no
+  /// longer valid afterwards.
+  void close();
+
+  bool isOpen() const;
+  const char* begin() const;
+  const char* end() const;
+  size_t size() const;
+
+private:
+  // disabled copy constructor and assignement operator.
+  MappedFile(const MappedFile&);
+  void operator=(const MappedFile&);
+
+  bool map(void* handle);
+
+  const char* begin_;
+  size_t size_;
+  bool isOpen_;
+#if defined(_WIN32)
+  void* mapping_;
+#endif
+};
+
+/** \brief Receives the events produced by a SaxReader.
+ *
+ * Every value of the document produces either a single scalar callback, or
+ * an onObjectBegin() / onObjectEnd() (or onArrayBegin() / onArrayEnd()) pair
+ * with the values of the members in between. Each member value of an object
+ * is preceded by onKey(). Begin and end callbacks are always balanced, even
+ * when parsing fails.
+ *
+ * Ranges passed to onString(), onKey() and onComment() are only valid for
+ * the duration of the call. They point into the parsed document when the
+ * text has no escape sequence, into a buffer reused by the reader otherwise.
  *
+ * All callbacks do nothing by default, so a handler only needs to override
+ * the events it cares about. SaxReader::getOffsetStart() and
+ * SaxReader::getOffsetLimit() give the location of the current value.
  */
-class JSON_API Reader {
+class JSON_API SaxHandler {
+public:
+  virtual ~SaxHandler();
+
+  virtual void onNull();
+  virtual void onBool(bool value);
+  /// A negative integer.
+  virtual void onInt(LargestInt value);
+  /// A non-negative integer.
+  virtual void onUInt(LargestUInt value);
+  /// A number with a fraction or an exponent, or an integer too large to be
+  /// represented by onInt() or onUInt().
+  virtual void onDouble(double value);
+  /// A string value, UTF-8 encoded, with escape sequences decoded.
+  virtual void onString(const char* begin, const char* end);
+  virtual void onObjectBegin();
+  /// Name of the next object member, decoded like onString().
+  virtual void onKey(const char* begin, const char* end);
+  virtual void onObjectEnd();
+  virtual void onArrayBegin();
+  virtual void onArrayEnd();
+  /** \brief A comment, including its delimiters.
+   * Only called when comments are collected.
+   * \param placement #commentAfterOnSameLine if the comment follows the
+   * previous value on the same line, #commentBefore otherwise (it then
+   * belongs to the next value, or to the whole document if none follows).
+   */
+  virtual void
+  onComment(const char* begin, const char* end, CommentPlacement placement);
+};
+
+/** \brief Tokenize a <a HREF="http://www.json.org">JSON</a> document and
+ * report its content to a SaxHandler, without building any Value.
+ *
+ * The grammar, Features and error reporting are the same as Reader, which is
+ * implemented on top of this class.
+ *
+ * Example of usage:
+ * \code
+ * class IpdHandler : public Json::SaxHandler {
+ *   ...
+ * };
+ * IpdHandler handler;
+ * Json::SaxReader reader;
+ * if (!reader.parseFile("osvr_user_settings.json", handler))
+ *   std::cerr << reader.getFormattedErrorMessages();
+ * \endcode
+ */
+class JSON_API SaxReader {
 public:
   typedef char Char;
   typedef const Char* Location;
@@ -46,6 +159,251 @@ public:
     std::string message;
   };
 
+  /** \brief Constructs a SaxReader allowing all features
+   * for parsing.
+   */
+  SaxReader();
+
+  /** \brief Constructs a SaxReader allowing the specified feature set
+   * for parsing.
+   */
+  SaxReader(const Features& features);
+
+  /** \brief Parse a <a HREF="http://www.json.org">JSON</a> document.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded string of
+   *                 the document to read.
+   * \param endDoc Pointer on the end of the UTF-8 encoded string of the
+   *               document to read. Must be >= beginDoc.
+   * \param handler Receives the content of the document.
+   * \param collectComments \c true to report comments to the handler.
+   *                        This parameter is ignored if
+   *                        Features::allowComments_ is \c false.
+   * \return \c true if the document was successfully parsed, \c false if an
+   * error occurred.
+   */
+  bool parse(const char* beginDoc,
+             const char* endDoc,
+             SaxHandler& handler,
+             bool collectComments = true);
+
+  /// Same as parse(const char*, const char*, SaxHandler&, bool). The
+  /// document is copied so that error messages can refer to it.
+  bool parse(const std::string& document,
+             SaxHandler& handler,
+             bool collectComments = true);
+
+  /// \brief Parse from input stream.
+  bool
+  parse(std::istream& is, SaxHandler& handler, bool collectComments = true);
+
+  /** \brief Parse a file over a read-only memory mapping of it.
+   * \see Reader::parseFile()
+   */
+  bool parseFile(const std::string& path,
+                 SaxHandler& handler,
+                 bool collectComments = true);
+#if defined(_WIN32)
+  bool parseFile(const std::wstring& path,
+                 SaxHandler& handler,
+                 bool collectComments = true);
+#endif
+
+  /** \brief Only report the values at \a pointer in the next parses.
+   *
+   * \a pointer is a <a HREF="https://tools.ietf.org/html/rfc6901">JSON
+   * Pointer</a>, such as "/personalSettings/eyes/left/pupilDistance". Once a
+   * path is added, only the selected values and the containers leading to
+   * them are reported. The other members and elements are skipped by
+   * matching brackets, without being decoded: they are only checked for
+   * balanced brackets and terminated strings and comments. Skipped elements
+   * of an array that come before a selected one are reported as null, so that
+   * the selected ones keep their index. Comments are only reported within
+   * the selected values.
+   *
+   * \return \c false if \a pointer is not a valid JSON Pointer.
+   */
+  bool addPath(const std::string& pointer);
+
+  /// Remove the paths added by addPath(), so that whole documents are
+  /// reported again.
+  void clearPaths();
+
+  /// \c true if addPath() was called since the last clearPaths().
+  bool hasPaths() const;
+
+  /** \brief Offset of the first byte of the value being reported.
+   * Only meaningful during a SaxHandler callback. For onObjectEnd() and
+   * onArrayEnd(), this is the offset of the opening bracket.
+   */
+  size_t getOffsetStart() const;
+
+  /** \brief Offset just past the last byte of the value being reported.
+   * Only meaningful during a SaxHandler callback. For onObjectBegin() and
+   * onArrayBegin(), this is just past the opening bracket.
+   */
+  size_t getOffsetLimit() const;
+
+  /** \brief Range of the document being parsed, or of the last one parsed.
+   * Copies made by parse(const std::string&, SaxHandler&, bool) and
+   * parse(std::istream&, SaxHandler&, bool), and mappings made by
+   * parseFile(), stay valid until the next parse.
+   */
+  const char* getDocumentBegin() const;
+  /// \see getDocumentBegin()
+  const char* getDocumentEnd() const;
+
+  /// \see Reader::getFormattedErrorMessages()
+  std::string getFormattedErrorMessages() const;
+
+  /// \see Reader::getStructuredErrors()
+  std::vector<StructuredError> getStructuredErrors() const;
+
+  /// \see Reader::pushError(const Value&, const std::string&)
+  bool pushError(const Value& value, const std::string& message);
+
+  /// \see Reader::pushError(const Value&, const std::string&, const Value&)
+  bool pushError(const Value& value,
+                 const std::string& message,
+                 const Value& extra);
+
+  /// \see Reader::good()
+  bool good() const;
+
+private:
+  enum TokenType {
+    tokenEndOfStream = 0,
+    tokenObjectBegin,
+    tokenObjectEnd,
+    tokenArrayBegin,
+    tokenArrayEnd,
+    tokenString,
+    tokenNumber,
+    tokenTrue,
+    tokenFalse,
+    tokenNull,
+    tokenArraySeparator,
+    tokenMemberSeparator,
+    tokenComment,
+    tokenError
+  };
+
+  class Token {
+  public:
+    TokenType type_;
+    Location start_;
+    Location end_;
+    /// For tokenNumber: \c true if the number has a fraction or an exponent.
+    bool isReal_;
+  };
+
+  class ErrorInfo {
+  public:
+    Token token_;
+    std::string message_;
+    Location extra_;
+  };
+
+  typedef std::deque<ErrorInfo> Errors;
+
+  /// Node of the tree of paths given to addPath(), the root being the
+  /// document itself.
+  class PathNode {
+  public:
+    std::string key_;
+    /// key_ as an array index, or ArrayIndex(-1) if it is not one.
+    ArrayIndex index_;
+    /// Number of elements an array must have to reach the largest index of
+    /// the children.
+    ArrayIndex indexLimit_;
+    /// \c true if the whole value is reported.
+    bool selected_;
+    std::vector<int> children_;
+  };
+
+  typedef std::vector<PathNode> PathNodes;
+
+  bool readToken(Token& token);
+  void skipSpaces();
+  void skipSpacesAndComments();
+  bool match(Location pattern, int patternLength);
+  bool readComment();
+  bool readCStyleComment();
+  bool readCppStyleComment();
+  bool readString();
+  bool readNumber();
+  bool readValue();
+  bool readObject(Token& token);
+  bool readObjectMembers();
+  bool readArray(Token& token);
+  bool readArrayElements();
+  bool readPathMember(int path, Location nameBegin, Location nameEnd);
+  bool readPathElement(int path, ArrayIndex index);
+  int findPath(int parent, Location keyBegin, Location keyEnd) const;
+  int findPath(int parent, ArrayIndex index) const;
+  bool nextIsContainer();
+  bool skipValue();
+  bool skipContainer();
+  void setValueRange(Location start, Location limit);
+  bool decodeNumber(Token& token);
+  bool decodeNumber(Token& token, Value& decoded);
+  bool decodeInteger(Token& token, bool& isNegative, LargestUInt& magnitude);
+  bool decodeString(Token& token, Location& begin, Location& end);
+  bool decodeString(Token& token, std::string& decoded);
+  bool decodeDouble(Token& token, double& decoded);
+  bool decodeUnicodeCodePoint(Token& token,
+                              Location& current,
+                              Location end,
+                              unsigned int& unicode);
+  bool decodeUnicodeEscapeSequence(Token& token,
+                                   Location& current,
+                                   Location end,
+                                   unsigned int& unicode);
+  bool addError(const std::string& message, Token& token, Location extra = 0);
+  bool recoverFromError(TokenType skipUntilToken);
+  bool addErrorAndRecover(const std::string& message,
+                          Token& token,
+                          TokenType skipUntilToken);
+  Char getNextChar();
+  void
+  getLocationLineAndColumn(Location location, int& line, int& column) const;
+  std::string getLocationLineAndColumn(Location location) const;
+  void skipCommentTokens(Token& token);
+  bool parseMappedFile(bool opened,
+                       const std::string& path,
+                       SaxHandler& handler,
+                       bool collectComments);
+
+  SaxHandler* handler_;
+  Errors errors_;
+  std::string document_;
+  std::string decoded_;
+  MappedFile mappedFile_;
+  Location begin_;
+  Location end_;
+  Location current_;
+  Location lastValueEnd_;
+  size_t valueStart_;
+  size_t valueLimit_;
+  Features features_;
+  bool collectComments_;
+  bool rootIsContainer_;
+  PathNodes paths_;
+  /// Node of paths_ of the value being read, -1 if it is read entirely.
+  int path_;
+};  // SaxReader
+
+/** \brief Unserialize a <a HREF="http://www.json.org">JSON</a> document into a
+ *Value.
+ *
+ * This is a SaxHandler building the Value tree from the events of a
+ * SaxReader.
+ */
+class JSON_API Reader : private SaxHandler {
+public:
+  typedef char Char;
+  typedef const Char* Location;
+  typedef SaxReader::StructuredError StructuredError;
+
   /** \brief Constructs a Reader allowing all features
    * for parsing.
    */
@@ -100,6 +458,65 @@ public:
   /// \see Json::operator>>(std::istream&, Json::Value&).
   bool parse(std::istream& is, Value& root, bool collectComments = true);
 
+  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a>
+   * file, parsing directly over a read-only memory mapping of it.
+   *
+   * No copy of the document is made. The mapping is kept by the Reader until
+   * the next call to parseFile() so that error messages can still refer to
+   * the text.
+   * \param path Path of the UTF-8 encoded file to read.
+   * \param root [out] Contains the root value of the document if it was
+   *             successfully parsed.
+   * \param collectComments See parse(const std::string&, Value&, bool).
+   * \return \c true if the document was successfully parsed, \c false if the
+   * file could not be opened or an error occurred.
+   */
+  bool
+  parseFile(const std::string& path, Value& root, bool collectComments = true);
+#if defined(_WIN32)
+  /// Same as parseFile(const std::string&, Value&, bool), for wide character
+  /// paths.
+  bool
+  parseFile(const std::wstring& path, Value& root, bool collectComments = true);
+#endif
+
+  /** \brief Update a tree to an edited version of its document.
+   *
+   * The bytes that differ between the two documents are found by skipping
+   * their common prefix and suffix. Only the smallest value of \a root
+   * that encloses them is re-parsed from \a newDocument and spliced into
+   * the tree, so that the parsing is proportional to the size of that value
+   * rather than of the document. The offsets of the values that follow it
+   * are shifted in place. When no value short of the root can hold the new
+   * text, the whole document is parsed again. So is it when built with
+   * JSON_COMPACT_VALUE and \a root was parsed without comments, since its
+   * values then have no offsets.
+   *
+   * \param oldDocument The document \a root was successfully parsed from.
+   * \param root [in,out] Tree parsed from \a oldDocument and not modified
+   *             since, with the same Features, collectComments and paths
+   *             (the whole document is parsed again if paths were added).
+   * \param newDocument The edited document.
+   * \param collectComments See parse(const std::string&, Value&, bool).
+   *             Edits within a value holding a comment cause the whole
+   *             document to be parsed again, since a comment may belong to
+   *             a value outside of the edited one.
+   * \return \c true if \a newDocument was successfully parsed.
+   */
+  bool reparse(const char* oldBeginDoc,
+               const char* oldEndDoc,
+               Value& root,
+               const char* newBeginDoc,
+               const char* newEndDoc,
+               bool collectComments = true);
+
+  /// Same as reparse(const char*, const char*, Value&, const char*,
+  /// const char*, bool).
+  bool reparse(const std::string& oldDocument,
+               Value& root,
+               const std::string& newDocument,
+               bool collectComments = true);
+
   /** \brief Returns a user friendly string that list errors in the parsed
    * document.
    * \return Formatted error message with the list of errors with their location
@@ -131,6 +548,41 @@ public:
    */
   std::vector<StructuredError> getStructuredErrors() const;
 
+  /** \brief Allocate the trees of the next parses from \a arena.
+   * Containers, member names, strings and comments then come from the arena
+   * instead of the heap. The parsed root must be destroyed before the arena
+   * is released. Pass 0 to go back to heap allocation.
+   * \see ValueArena
+   */
+  void setArena(ValueArena* arena);
+
+  /** \brief Allocate the trees of the next parses from \a resource.
+   * Like setArena(), for any MemoryResource: containers, strings and
+   * comments then come from the resource, and member names too if it is
+   * monotonic. The parsed root must be destroyed before the resource. Pass
+   * 0 to go back to heap allocation.
+   */
+  void setMemoryResource(MemoryResource* resource);
+
+  /** \brief Intern the member names of the next parses in \a keyTable.
+   * Objects then store the interned names instead of copies of their own.
+   * The table must outlive the parsed values and their copies. Pass 0 to
+   * go back to copying names.
+   * \see KeyTable
+   */
+  void setKeyTable(KeyTable* keyTable);
+
+  /** \brief Only decode the values at \a pointer in the next parses.
+   * The root then only holds the selected values, within the objects and
+   * arrays leading to them. Nothing is decoded or allocated for the rest of
+   * the document.
+   * \see SaxReader::addPath()
+   */
+  bool addPath(const std::string& pointer);
+
+  /// \see SaxReader::clearPaths()
+  void clearPaths();
+
   /** \brief Add a semantic error message.
    * \param value JSON Value location associated with the error
    * \param message The error message.
@@ -155,90 +607,52 @@ public:
   bool good() const;
 
 private:
-  enum TokenType {
-    tokenEndOfStream = 0,
-    tokenObjectBegin,
-    tokenObjectEnd,
-    tokenArrayBegin,
-    tokenArrayEnd,
-    tokenString,
-    tokenNumber,
-    tokenTrue,
-    tokenFalse,
-    tokenNull,
-    tokenArraySeparator,
-    tokenMemberSeparator,
-    tokenComment,
-    tokenError
-  };
-
-  class Token {
-  public:
-    TokenType type_;
-    Location start_;
-    Location end_;
-  };
-
-  class ErrorInfo {
-  public:
-    Token token_;
-    std::string message_;
-    Location extra_;
-  };
-
-  typedef std::deque<ErrorInfo> Errors;
-
-  bool readToken(Token& token);
-  void skipSpaces();
-  bool match(Location pattern, int patternLength);
-  bool readComment();
-  bool readCStyleComment();
-  bool readCppStyleComment();
-  bool readString();
-  void readNumber();
-  bool readValue();
-  bool readObject(Token& token);
-  bool readArray(Token& token);
-  bool decodeNumber(Token& token);
-  bool decodeNumber(Token& token, Value& decoded);
-  bool decodeString(Token& token);
-  bool decodeString(Token& token, std::string& decoded);
-  bool decodeDouble(Token& token);
-  bool decodeDouble(Token& token, Value& decoded);
-  bool decodeUnicodeCodePoint(Token& token,
-                              Location& current,
-                              Location end,
-                              unsigned int& unicode);
-  bool decodeUnicodeEscapeSequence(Token& token,
-                                   Location& current,
-                                   Location end,
-                                   unsigned int& unicode);
-  bool addError(const std::string& message, Token& token, Location extra = 0);
-  bool recoverFromError(TokenType skipUntilToken);
-  bool addErrorAndRecover(const std::string& message,
-                          Token& token,
-                          TokenType skipUntilToken);
-  void skipUntilSpace();
-  Value& currentValue();
-  Char getNextChar();
-  void
-  getLocationLineAndColumn(Location location, int& line, int& column) const;
-  std::string getLocationLineAndColumn(Location location) const;
-  void addComment(Location begin, Location end, CommentPlacement placement);
-  void skipCommentTokens(Token& token);
+  // SaxHandler callbacks, building the tree.
+  virtual void onNull();
+  virtual void onBool(bool value);
+  virtual void onInt(LargestInt value);
+  virtual void onUInt(LargestUInt value);
+  virtual void onDouble(double value);
+  virtual void onString(const char* begin, const char* end);
+  virtual void onObjectBegin();
+  virtual void onKey(const char* begin, const char* end);
+  virtual void onObjectEnd();
+  virtual void onArrayBegin();
+  virtual void onArrayEnd();
+  virtual void
+  onComment(const char* begin, const char* end, CommentPlacement placement);
+
+  bool parseAgain(const char* beginDoc,
+                  const char* endDoc,
+                  Value& root,
+                  bool collectComments);
+  void startDocument(Value& root, bool collectComments);
+  bool endDocument(Value& root, bool successful);
+  Value& nextValue();
+  void setValue(Value& decoded);
+  void beginContainer(ValueType type);
+  void endContainer();
+  void setLastValue(Value& value);
+  void addedTo(const Value& container);
+  Value* lastValue();
 
   typedef std::stack<Value*> Nodes;
+  SaxReader sax_;
   Nodes nodes_;
-  Errors errors_;
-  std::string document_;
-  Location begin_;
-  Location end_;
-  Location current_;
-  Location lastValueEnd_;
+  Value* member_;
+  // Value that a comment on the same line goes to. Containers that store
+  // their members in a single block (see JSON_USE_FLAT_MAP) move them when
+  // a sibling is added, so it is then found again by its start offset.
   Value* lastValue_;
+  Value* lastParent_;
+  size_t lastStart_;
+  bool lastMoved_;
+  // false when the offsets of values are not recorded (see
+  // JSON_COMPACT_VALUE).
+  bool storeOffsets_;
   std::string commentsBefore_;
-  Features features_;
-  bool collectComments_;
+  MemoryResource* resource_;
+  KeyTable* keyTable_;
 };  // Reader
 
 /** Interface for reading JSON from a char array.
@@ -0,0 +1,196 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_RESOURCE_H_INCLUDED
+#define CPPTL_JSON_RESOURCE_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "config.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstddef>
+#include <new>
+
+namespace Json {
+
+/** \brief Source of memory for Value trees.
+ *
+ * A Value built with a resource (see Value(ValueType, MemoryResource&) and
+ * Reader::setMemoryResource()) allocates its container, the elements or
+ * members of that container, its long strings and its comments from the
+ * resource, and gives them back to it when destroyed. Values allocated from
+ * a resource must be destroyed before the resource.
+ *
+ * Implementations provided: ValueArena (monotonic, freed all at once),
+ * PoolResource (size classes shared by all threads) and
+ * ThreadLocalPoolResource (size classes cached per thread). Derive from
+ * MemoryResource to provide another strategy.
+ */
+class JSON_API MemoryResource {
+public:
+  virtual ~MemoryResource();
+
+  /// Returns \a size bytes aligned for any Value member. Never returns 0.
+  void* allocate(size_t size) { return doAllocate(size); }
+
+  /// Gives back \a memory, returned by allocate(\a size).
+  void deallocate(void* memory, size_t size) { doDeallocate(memory, size); }
+
+  /// Copy of [\a begin, \a begin + \a length), followed by a null character,
+  /// from allocate(\a length + 1).
+  char* duplicate(const char* begin, size_t length);
+
+  /** \brief \c true if deallocate() does nothing.
+   * Memory then only comes back when the whole resource is released, and
+   * objects in the resource keep their member names in it (see ValueArena).
+   */
+  bool isMonotonic() const { return monotonic_; }
+
+protected:
+  explicit MemoryResource(bool monotonic = false) : monotonic_(monotonic) {}
+
+  virtual void* doAllocate(size_t size) = 0;
+  virtual void doDeallocate(void* memory, size_t size) = 0;
+
+private:
+  // disabled copy constructor and assignement operator.
+  MemoryResource(const MemoryResource&);
+  void operator=(const MemoryResource&);
+
+  bool monotonic_;
+};
+
+/** \brief Pool of blocks sorted by size class.
+ *
+ * Small requests are rounded up to a size class, and freed blocks are kept
+ * in a list per class to serve the next requests of that class. Blocks are
+ * carved from large chunks, which are only freed by release() or the
+ * destructor. Requests larger than maxPooledSize go straight to operator
+ * new and operator delete.
+ *
+ * Suits trees that are edited for a long time: unlike a ValueArena, the
+ * memory of removed members and replaced strings is reused.
+ *
+ * A PoolResource is thread-safe when the library is built with C++11
+ * threads (see JSON_HAS_STD_THREAD).
+ */
+class JSON_API PoolResource : public MemoryResource {
+public:
+  /// Largest request served from the pool.
+  enum { maxPooledSize = 4096 };
+
+  /// \param chunkSize Size of the first chunk. Following chunks are twice
+  /// as large as the previous one, up to a limit.
+  explicit PoolResource(size_t chunkSize = 4096);
+  ~PoolResource();
+
+  /// Free all pooled blocks at once. Values allocated from the pool must
+  /// have been destroyed.
+  void release();
+
+protected:
+  virtual void* doAllocate(size_t size);
+  virtual void doDeallocate(void* memory, size_t size);
+
+private:
+  struct Impl;
+
+  Impl* impl_;
+};
+
+/** \brief Blocks cached per thread.
+ *
+ * Like PoolResource, requests up to maxPooledSize are rounded up to a size
+ * class, but freed blocks are kept in lists of the calling thread, so that
+ * allocating and freeing never takes a lock. Each block comes from operator
+ * new on its own: a Value may be freed by another thread than the one that
+ * allocated it, and the blocks cached by a thread are freed when it exits.
+ * At most maxCachedBlocks blocks of each class are cached per thread.
+ *
+ * All instances share the caches of a thread, so instance() is usually
+ * enough. Without thread_local support (see JSON_HAS_THREAD_LOCAL), nothing
+ * is cached and every request goes to operator new.
+ */
+class JSON_API ThreadLocalPoolResource : public MemoryResource {
+public:
+  /// Largest request served from the caches.
+  enum { maxPooledSize = 4096 };
+  /// Most blocks of a size class kept by a thread.
+  enum { maxCachedBlocks = 256 };
+
+  ThreadLocalPoolResource() {}
+
+  /// Resource for the whole process, never destroyed.
+  static ThreadLocalPoolResource& instance();
+
+protected:
+  virtual void* doAllocate(size_t size);
+  virtual void doDeallocate(void* memory, size_t size);
+};
+
+/** \brief Standard allocator drawing from a MemoryResource.
+ *
+ * Without a resource, memory comes from operator new, so the same
+ * container type can live on the heap or in a resource.
+ */
+template <typename T> class ResourceAllocator {
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <typename U> struct rebind { typedef ResourceAllocator<U> other; };
+
+  ResourceAllocator() : resource_(0) {}
+  explicit ResourceAllocator(MemoryResource* resource) : resource_(resource) {}
+  template <typename U>
+  ResourceAllocator(const ResourceAllocator<U>& other)
+      : resource_(other.resource()) {}
+
+  MemoryResource* resource() const { return resource_; }
+
+  pointer address(reference value) const { return &value; }
+  const_pointer address(const_reference value) const { return &value; }
+
+  pointer allocate(size_type count, const void* = 0) {
+    if (resource_)
+      return static_cast<pointer>(resource_->allocate(count * sizeof(T)));
+    return static_cast<pointer>(::operator new(count * sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type count) {
+    if (resource_)
+      resource_->deallocate(p, count * sizeof(T));
+    else
+      ::operator delete(p);
+  }
+
+  size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+  void construct(pointer p, const T& value) { new (p) T(value); }
+  void destroy(pointer p) { p->~T(); }
+
+private:
+  MemoryResource* resource_;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ResourceAllocator<T>& a,
+                       const ResourceAllocator<U>& b) {
+  return a.resource() == b.resource();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ResourceAllocator<T>& a,
+                       const ResourceAllocator<U>& b) {
+  return a.resource() != b.resource();
+}
+
+} // namespace Json
+
+#endif // CPPTL_JSON_RESOURCE_H_INCLUDED
@@ -0,0 +1,119 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef CPPTL_JSON_SINK_H_INCLUDED
+#define CPPTL_JSON_SINK_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "config.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstddef>
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+namespace Json {
+
+/** \brief Destination of the characters of a written document.
+ *
+ * Writers hand their output to a sink in large blocks (see Formatter), so
+ * that a document can go to a file, a socket or a memory region without
+ * being built as a string first. Derive from OutputSink to write elsewhere.
+ */
+class JSON_API OutputSink {
+public:
+  virtual ~OutputSink();
+
+  /// Writes the \a length characters at \a data.
+  virtual void write(const char* data, size_t length) = 0;
+
+protected:
+  OutputSink() {}
+
+private:
+  // disabled copy constructor and assignement operator.
+  OutputSink(const OutputSink&);
+  void operator=(const OutputSink&);
+};
+
+/// Appends to a string, which the caller owns and may reuse.
+class JSON_API StringSink : public OutputSink {
+public:
+  explicit StringSink(std::string& document) : document_(document) {}
+
+  virtual void write(const char* data, size_t length);
+
+private:
+  std::string& document_;
+};
+
+/// Writes to a stream.
+class JSON_API StreamSink : public OutputSink {
+public:
+  explicit StreamSink(std::ostream& stream) : stream_(stream) {}
+
+  virtual void write(const char* data, size_t length);
+
+private:
+  std::ostream& stream_;
+};
+
+/// Writes to a stdio FILE, which is neither flushed nor closed. Check
+/// ferror() for errors.
+class JSON_API FileSink : public OutputSink {
+public:
+  explicit FileSink(FILE* file) : file_(file) {}
+
+  virtual void write(const char* data, size_t length);
+
+private:
+  FILE* file_;
+};
+
+/** \brief Writes to a file descriptor, such as a file, pipe or socket.
+ *
+ * Partial and interrupted writes are resumed. After an error, nothing more
+ * is written and good() returns \c false.
+ */
+class JSON_API FdSink : public OutputSink {
+public:
+  explicit FdSink(int fd) : fd_(fd), good_(true) {}
+
+  virtual void write(const char* data, size_t length);
+
+  bool good() const { return good_; }
+
+private:
+  int fd_;
+  bool good_;
+};
+
+/** \brief Writes into a fixed memory region, such as a mapped file.
+ *
+ * Characters past the end of the region are dropped, but still counted by
+ * size(), so that the region can be enlarged to the needed size and the
+ * document written again.
+ */
+class JSON_API MemorySink : public OutputSink {
+public:
+  MemorySink(char* begin, size_t capacity)
+      : begin_(begin), capacity_(capacity), size_(0) {}
+
+  virtual void write(const char* data, size_t length);
+
+  /// Characters written so far, including those that did not fit.
+  size_t size() const { return size_; }
+  /// \c true if the whole document fit in the region.
+  bool good() const { return size_ <= capacity_; }
+
+private:
+  char* begin_;
+  size_t capacity_;
+  size_t size_;
+};
+
+} // namespace Json
+
+#endif // CPPTL_JSON_SINK_H_INCLUDED
@@ -8,6 +8,9 @@
 
 #if !defined(JSON_IS_AMALGAMATION)
 #include "forwards.h"
+#include "arena.h"
+#include "flatarray.h"
+#include "flatmap.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
 #include <string>
 #include <vector>
@@ -115,6 +118,7 @@ private:
  */
 class JSON_API Value {
   friend class ValueIteratorBase;
+  friend class Formatter;
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   friend class ValueInternalLink;
   friend class ValueInternalMap;
@@ -158,6 +162,13 @@ public:
 #endif // defined(JSON_HAS_INT64)
 
 private:
+  /// Size of the buffers holding short strings and member names inline,
+  /// including the null terminator.
+#if defined(JSON_COMPACT_VALUE)
+  enum { smallStringSize = 8 };
+#else
+  enum { smallStringSize = 16 };
+#endif
 #ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   class CZString {
@@ -165,11 +176,15 @@ private:
     enum DuplicationPolicy {
       noDuplication = 0,
       duplicate,
-      duplicateOnCopy
+      duplicateOnCopy,
+      arenaOwned ///< allocated from the monotonic resource of the map
     };
-    CZString(ArrayIndex index);
+    CZString(ArrayIndex index = 0);
     CZString(const char* cstr, DuplicationPolicy allocate);
     CZString(const CZString& other);
+#if JSON_HAS_RVALUE_REFERENCES
+    CZString(CZString&& other);
+#endif
     ~CZString();
     CZString& operator=(CZString other);
     bool operator<(const CZString& other) const;
@@ -177,19 +192,36 @@ private:
     ArrayIndex index() const;
     const char* c_str() const;
     bool isStaticString() const;
+    void swap(CZString& other);
+#ifdef JSON_USE_FLAT_MAP
+    unsigned int hash() const;
+#endif
 
   private:
-    void swap(CZString& other);
-    const char* cstr_;
+    union {
+      const char* cstr_;
+      // The name itself when small_, null terminated.
+      char chars_[smallStringSize];
+    };
     ArrayIndex index_;
+    bool small_; ///< short duplicated names are kept in chars_
   };
 
 public:
-#ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
+#if defined(JSON_USE_FLAT_MAP)
+  typedef FlatMap<CZString,
+                  Value,
+                  ResourceAllocator<std::pair<CZString, Value> > > ObjectValues;
+#elif !defined(JSON_USE_CPPTL_SMALLMAP)
+  typedef std::map<CZString,
+                   Value,
+                   std::less<CZString>,
+                   ResourceAllocator<std::pair<const CZString, Value> > >
+  ObjectValues;
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
-#endif // ifndef JSON_USE_CPPTL_SMALLMAP
+#endif // if defined(JSON_USE_FLAT_MAP)
+  typedef FlatArray<Value, ResourceAllocator<Value> > ArrayValues;
 #endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 #endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 
@@ -235,11 +267,32 @@ Json::Value obj_value(Json::objectValue); // {}
   Value(const CppTL::ConstString& value);
 #endif
   Value(bool value);
-  /// Deep copy.
+  /** \brief Create a default Value of the given type, allocated from
+   * \a resource.
+   * An array or an object gets its elements from the resource, and an
+   * object of a monotonic resource (such as a ValueArena) its member names.
+   * Elements themselves are ordinary Values: only the ones built with a
+   * resource keep their content in it.
+   * \see MemoryResource
+   */
+  Value(ValueType type, MemoryResource& resource);
+  /// Copy the string [\a beginValue, \a endValue) into \a resource.
+  Value(const char* beginValue,
+        const char* endValue,
+        MemoryResource& resource);
+  /// Deep copy. The copy never uses the resource of \a other. With
+  /// JSON_COPY_ON_WRITE, arrays and objects not in a resource are only
+  /// copied once modified.
   Value(const Value& other);
+#if JSON_HAS_RVALUE_REFERENCES
+  /// Take everything from \a other, which is left null. Nothing is copied,
+  /// so the value keeps using the resource of \a other, if any.
+  Value(Value&& other);
+#endif
   ~Value();
 
-  // Deep copy, then swap(other).
+  // Deep copy, then swap(other). Assigning an rvalue moves it instead of
+  // copying it (see Value(Value&&)).
   Value& operator=(Value other);
   /// Swap everything.
   void swap(Value& other);
@@ -311,12 +364,21 @@ Json::Value obj_value(Json::objectValue); // {}
   /// \post type() is arrayValue
   void resize(ArrayIndex size);
 
+  /// Make room for size elements, so that appending up to that size does
+  /// not move the elements already in the array.
+  /// \pre type() is arrayValue or nullValue
+  /// \post type() is arrayValue
+  void reserve(ArrayIndex size);
+
   /// Access an array element (zero based index ).
   /// If the array contains less than index element, then null value are
   /// inserted
   /// in the array so that its size is index+1.
   /// (You may need to say 'value[0u]' to get your compiler to distinguish
   ///  this from the operator[] which takes a string.)
+  /// The elements are contiguous: as with a std::vector, growing the array
+  /// (here, with append() or resize()) may move them, which invalidates
+  /// references and iterators to its elements. reserve() avoids that.
   Value& operator[](ArrayIndex index);
 
   /// Access an array element (zero based index ).
@@ -346,9 +408,24 @@ Json::Value obj_value(Json::objectValue); // {}
   /// \brief Append value to array at the end.
   ///
   /// Equivalent to jsonvalue[jsonvalue.size()] = value;
+  /// \see operator[](ArrayIndex) for when element references stay valid.
   Value& append(const Value& value);
+#if JSON_HAS_RVALUE_REFERENCES
+  /// \brief Move value to the end of the array, leaving it null.
+  Value& append(Value&& value);
+#endif
+  /// \brief Append a default value of the given type to array at the end.
+  ///
+  /// The element is constructed in place, and can then be filled through the
+  /// returned reference without copying it.
+  Value& append(ValueType type);
 
-  /// Access an object value by name, create a null member if it does not exist.
+  /// \brief Access an object value by name, create a null member if it does
+  /// not exist.
+  ///
+  /// With JSON_USE_FLAT_MAP, members are kept sorted in one array: adding a
+  /// member moves those after it, which invalidates references and
+  /// iterators to the members of the object.
   Value& operator[](const char* key);
   /// Access an object value by name, returns null if there is no member with
   /// that name.
@@ -371,6 +448,18 @@ Json::Value obj_value(Json::objectValue); // {}
    * \endcode
    */
   Value& operator[](const StaticString& key);
+  /// \brief Same as operator[](), for parsers, which can not choose the order
+  /// of the members.
+  ///
+  /// The new member may be left out of order: sortMembers() must be called
+  /// before the object is used otherwise than with addMember(). With
+  /// JSON_USE_FLAT_MAP, this builds an object in O(n log n) whatever the
+  /// order of its members, instead of O(n^2) in descending order.
+  Value& addMember(const std::string& key);
+  /// \see addMember(const std::string&)
+  Value& addMember(const StaticString& key);
+  /// Restores the order of the members added with addMember().
+  void sortMembers();
 #ifdef JSON_USE_CPPTL
   /// Access an object value by name, create a null member if it does not exist.
   Value& operator[](const CppTL::ConstString& key);
@@ -436,6 +525,12 @@ Json::Value obj_value(Json::objectValue); // {}
   void setComment(const char* comment, CommentPlacement placement);
   /// Comments must be //... or /* ... */
   void setComment(const char* comment, size_t len, CommentPlacement placement);
+  /// Same as above, the text being allocated from \a resource (the heap if
+  /// 0).
+  void setComment(const char* comment,
+                  size_t len,
+                  CommentPlacement placement,
+                  MemoryResource* resource);
   /// Comments must be //... or /* ... */
   void setComment(const std::string& comment, CommentPlacement placement);
   bool hasComment(CommentPlacement placement) const;
@@ -451,7 +546,8 @@ Json::Value obj_value(Json::objectValue); // {}
   iterator end();
 
   // Accessors for the [start, limit) range of bytes within the JSON text from
-  // which this value was parsed, if any.
+  // which this value was parsed, if any. When built with JSON_COMPACT_VALUE,
+  // the Reader only sets them when collecting comments.
   void setOffsetStart(size_t start);
   void setOffsetLimit(size_t limit);
   size_t getOffsetStart() const;
@@ -459,8 +555,32 @@ Json::Value obj_value(Json::objectValue); // {}
 
 private:
   void initBasic(ValueType type, bool allocated = false);
+  /// Copies [begin, begin + length) into value_.chars_ when it fits, else
+  /// into an allocated string. Only sets value_, allocated_ and small_.
+  void initString(const char* begin, unsigned int length);
+  const char* stringPointer() const;
+  /// Comment at \a placement, 0 if none. Same as getComment(), without
+  /// copy.
+  const char* commentText(CommentPlacement placement) const;
+#if defined(JSON_COPY_ON_WRITE)
+  /// Gives this value its own copy of its array or object if it shares it
+  /// with other values. Called before any modification of its elements.
+  void unshare();
+  /// Same as unshare(), for this value and all its elements and members.
+  void unshareAll();
+  /// \c true if this value's array or object is shared with other values.
+  bool isShared() const;
+  /// \c true if \a target is an element or member of this value, at any
+  /// depth. Containers shared with other values are not searched below this
+  /// value, as \a target can not be modified through them.
+  bool holds(const Value* target) const;
+#else
+  void unshare() {}
+#endif
 
-  Value& resolveReference(const char* key, bool isStatic);
+  /// Member named \a key, added if needed: in order, unless \a sorted is
+  /// \c false (see addMember()).
+  Value& resolveReference(const char* key, bool isStatic, bool sorted = true);
 
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   inline bool isItemAvailable() const { return itemIsUsed_ == 0; }
@@ -479,11 +599,30 @@ private:
     CommentInfo();
     ~CommentInfo();
 
-    void setComment(const char* text, size_t len);
+    void setComment(const char* text, size_t len, MemoryResource* resource);
 
     char* comment_;
+    bool fromResource_; ///< comment_ is a resource string
   };
 
+#if defined(JSON_COMPACT_VALUE)
+  // What a Value holds besides its payload, kept out of line since most
+  // values have neither comments nor offsets.
+  struct Metadata {
+    CommentInfo* comments_;
+    // [start, limit) byte offsets in the source JSON text from which the
+    // Value was extracted.
+    size_t start_;
+    size_t limit_;
+  };
+  class MetadataTable;
+
+  /// Metadata of this value, 0 if it has none.
+  Metadata* findMetadata() const;
+  /// Metadata of this value, added if it has none.
+  Metadata& metadata();
+#endif
+
   // struct MemberNamesTransform
   //{
   //   typedef const char *result_type;
@@ -499,25 +638,38 @@ private:
     double real_;
     bool bool_;
     char* string_;
+    // The string itself when small_, null terminated.
+    char chars_[smallStringSize];
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
     ValueInternalArray* array_;
     ValueInternalMap* map_;
 #else
+    ArrayValues* array_;
     ObjectValues* map_;
 #endif
   } value_;
   ValueType type_ : 8;
   unsigned int allocated_ : 1; // Notes: if declared as bool, bitfield is useless.
+  unsigned int small_ : 1; // string stored in value_.chars_, never allocated_
+  // string_ allocated from a MemoryResource that is not monotonic, and
+  // given back to it.
+  unsigned int fromResource_ : 1;
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   unsigned int itemIsUsed_ : 1; // used by the ValueInternalMap container.
   unsigned int memberNameIsStatic_ : 1;  // used by the ValueInternalMap container.
 #endif
+#if defined(JSON_COMPACT_VALUE)
+  // Key of the Metadata of this value in the MetadataTable, 0 if it has
+  // none.
+  unsigned int metadata_;
+#else
   CommentInfo* comments_;
 
   // [start, limit) byte offsets in the source JSON text from which this Value
   // was extracted.
   size_t start_;
   size_t limit_;
+#endif
 };
 
 /** \brief Experimental and untested: represents an element of the "path" to
@@ -935,6 +1087,7 @@ public:
   ValueIteratorBase();
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueIteratorBase(const Value::ObjectValues::iterator& current);
+  ValueIteratorBase(Value* element, Value* elements);
 #else
   ValueIteratorBase(const ValueInternalArray::IteratorState& state);
   ValueIteratorBase(const ValueInternalMap::IteratorState& state);
@@ -975,6 +1128,10 @@ protected:
 private:
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   Value::ObjectValues::iterator current_;
+  // Array element, and the first element of its array. elements_ is 0 for
+  // objects.
+  Value* element_;
+  Value* elements_;
   // Indicates that iterator is for a null value.
   bool isNull_;
 #else
@@ -1007,6 +1164,7 @@ private:
  */
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueConstIterator(const Value::ObjectValues::iterator& current);
+  ValueConstIterator(Value* element, Value* elements);
 #else
   ValueConstIterator(const ValueInternalArray::IteratorState& state);
   ValueConstIterator(const ValueInternalMap::IteratorState& state);
@@ -1063,6 +1221,7 @@ private:
  */
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueIterator(const Value::ObjectValues::iterator& current);
+  ValueIterator(Value* element, Value* elements);
 #else
   ValueIterator(const ValueInternalArray::IteratorState& state);
   ValueIterator(const ValueInternalMap::IteratorState& state);
@@ -8,6 +8,7 @@
 
 #if !defined(JSON_IS_AMALGAMATION)
 #include "value.h"
+#include "sink.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
 #include <vector>
 #include <string>
@@ -157,6 +158,201 @@ public:
   virtual StreamWriter* newStreamWriter(std::ostream*) const;
 };
 
+/** \brief Writes a Value in one pass, to a string or an OutputSink.
+ *
+ * Produces the same documents as the other writers, chosen by #Style, but
+ * formats numbers and escaped strings straight into the output instead of
+ * building a string per value, and decides whether an array fits on one
+ * line by writing it, then taking it back if it does not.
+ *
+ * Output to a sink goes through a buffer of about flushSize characters,
+ * which is kept from one write() to the next: a Formatter reused for many
+ * documents stops allocating once the buffer has grown.
+ *
+ * Usage:
+ * \code
+ *   Json::Formatter formatter(Json::Formatter::builtStyle);
+ *   formatter.setCommentStyle(Json::StreamWriter::CommentStyle::None);
+ *   Json::FileSink sink(stdout);
+ *   formatter.write(root, sink);
+ * \endcode
+ */
+class JSON_API Formatter {
+public:
+  /// Layout of the document, named after the writer producing it.
+  enum Style {
+    fastStyle,         ///< FastWriter: a single line, without comments.
+    styledStyle,       ///< StyledWriter.
+    styledStreamStyle, ///< StyledStreamWriter.
+    builtStyle ///< StreamWriterBuilder and OldCompressingStreamWriterBuilder.
+  };
+
+  /// Characters buffered before they are written to a sink.
+  enum { flushSize = 16384 };
+
+  /// Uses the defaults of the writer of \a style: indentation of 3 spaces
+  /// for styledStyle, a tab otherwise, " : " as colon (":" for fastStyle),
+  /// "null" for nulls, and a newline at the end (none for builtStyle).
+  explicit Formatter(Style style = styledStyle);
+
+  /// Indentation added at each level. With builtStyle, an empty
+  /// indentation also drops newlines.
+  void setIndentation(const std::string& indentation);
+  /// Comments are only written by styled and built styles. With builtStyle
+  /// and CommentStyle::All, arrays are never written on a single line.
+  void setCommentStyle(StreamWriter::CommentStyle::Enum cs);
+  void setColonSymbol(const std::string& colonSymbol);
+  void setNullSymbol(const std::string& nullSymbol);
+  void setEndingLineFeedSymbol(const std::string& endingLineFeedSymbol);
+
+  /// Appends the document of \a root to \a document.
+  void write(const Value& root, std::string& document);
+  /// Writes the document of \a root to \a sink.
+  void write(const Value& root, OutputSink& sink);
+
+private:
+  void writeDocument(const Value& root);
+  void writeValue(const Value& value);
+  void writeLeaf(const Value& value);
+  void writeArrayValue(const Value& value);
+  bool writeSingleLineArray(const Value& value);
+  void writeObjectValue(const Value& value);
+  void writeQuoted(const char* value);
+  void writeIndent();
+  void writeIndentOnce();
+  void writeWithIndent(const char* text);
+  void writeCommentBeforeValue(const Value& root);
+  void writeCommentAfterValueOnSameLine(const Value& root);
+  char lastChar() const;
+  void flush();
+
+  Style style_;
+  std::string indentation_;
+  StreamWriter::CommentStyle::Enum cs_;
+  std::string colonSymbol_;
+  std::string nullSymbol_;
+  std::string endingLineFeedSymbol_;
+
+  std::string buffer_;
+  std::string* document_; // buffer_, or the document passed to write()
+  OutputSink* sink_;
+  size_t start_;          // size of *document_ before the write
+  unsigned int depth_;
+  char flushedLast_;      // last character given to the sink
+  bool indented_;
+};
+
+/** \brief Writes a document from a sequence of calls, without any Value.
+ *
+ * The counterpart of SaxReader: values are written to the sink as they are
+ * given, so that large or generated documents never exist as a Value tree.
+ * Each complete top-level value is followed by a newline, so several
+ * documents can be written in a row.
+ *
+ * The styled layout is the one of StyledWriter: an array goes on a single
+ * line when its elements all fit and none is a non-empty container. To
+ * decide it without seeing the whole array first, the elements are written
+ * on one line, and laid out again one per line as soon as they do not fit.
+ * Nothing is flushed to the sink meanwhile.
+ *
+ * Calls that do not form valid JSON, such as a value in an object without
+ * key(), fail through JSON_ASSERT_MESSAGE.
+ *
+ * Usage:
+ * \code
+ *   Json::FileSink sink(stdout);
+ *   Json::StreamingWriter writer(sink, Json::StreamingWriter::styledStyle);
+ *   writer.beginObject();
+ *   writer.key("ipd");
+ *   writer.value(63.5);
+ *   writer.endObject();
+ *   writer.flush();
+ * \endcode
+ */
+class JSON_API StreamingWriter {
+public:
+  enum Style {
+    compactStyle, ///< Same output as FastWriter.
+    styledStyle   ///< Same output as StyledWriter.
+  };
+
+  explicit StreamingWriter(OutputSink& sink, Style style = compactStyle);
+  /// Flushes what remains in the buffer.
+  ~StreamingWriter();
+
+  /// Indentation added at each level of the styled layout. Default: 3
+  /// spaces.
+  void setIndentation(const std::string& indentation);
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+
+  /// Name of the next member of the current object.
+  void key(const char* name);
+  void key(const char* begin, const char* end);
+  void key(const std::string& name);
+
+  void null();
+  void value(bool value);
+  void value(Int value);
+  void value(UInt value);
+#if defined(JSON_HAS_INT64)
+  void value(Int64 value);
+  void value(UInt64 value);
+#endif // if defined(JSON_HAS_INT64)
+  void value(double value);
+  void value(const char* value);
+  void value(const char* begin, const char* end);
+  void value(const std::string& value);
+  /// Writes \a value, with its elements and members. Comments are dropped.
+  void value(const Value& value);
+
+  /// Gives the buffered characters to the sink.
+  void flush();
+
+private:
+  // disabled copy constructor and assignement operator.
+  StreamingWriter(const StreamingWriter&);
+  void operator=(const StreamingWriter&);
+
+  // Most elements an array may have to be written on a single line.
+  enum { maxSingleLineElements = 24 };
+
+  struct Frame {
+    bool isObject_;
+    ArrayIndex count_; // elements or members written
+  };
+
+  void beginContainer(bool isObject);
+  void endContainer(bool isObject);
+  void openPending();
+  void placeValue();
+  void valueDone();
+  void breakSingleLine(const Frame& frame);
+  void writeIndent();
+  void writeWithIndent(char text);
+  char lastChar() const;
+  void writeNumber(LargestInt value);
+  void writeNumber(LargestUInt value);
+
+  OutputSink& sink_;
+  Style style_;
+  std::string indentation_;
+  std::string buffer_;
+  std::string scratch_;    // elements being laid out again
+  std::vector<Frame> frames_;
+  size_t singleLineStart_; // where the "[ " of the single-line array is
+  size_t elementStarts_[maxSingleLineElements]; // from singleLineStart_ + 2
+  size_t documentStart_;   // where the current top-level value starts
+  unsigned int depth_;
+  char flushedLast_;       // last character given to the sink
+  bool pending_;    // the last container begun has no content yet
+  bool singleLine_; // an array is being written on a single line
+  bool afterKey_;
+};
+
 /** \brief Abstract class for writers.
  * \deprecated Use StreamWriter.
  */
@@ -196,12 +392,7 @@ public: // overridden from Writer
   virtual std::string write(const Value& root);
 
 private:
-  void writeValue(const Value& value);
-
-  std::string document_;
-  bool yamlCompatiblityEnabled_;
-  bool dropNullPlaceholders_;
-  bool omitEndingLineFeed_;
+  Formatter formatter_;
 };
 
 /** \brief Writes a Value in <a HREF="http://www.json.org">JSON</a> format in a
@@ -241,27 +432,7 @@ public: // overridden from Writer
   virtual std::string write(const Value& root);
 
 private:
-  void writeValue(const Value& value);
-  void writeArrayValue(const Value& value);
-  bool isMultineArray(const Value& value);
-  void pushValue(const std::string& value);
-  void writeIndent();
-  void writeWithIndent(const std::string& value);
-  void indent();
-  void unindent();
-  void writeCommentBeforeValue(const Value& root);
-  void writeCommentAfterValueOnSameLine(const Value& root);
-  bool hasCommentForValue(const Value& value);
-  static std::string normalizeEOL(const std::string& text);
-
-  typedef std::vector<std::string> ChildValues;
-
-  ChildValues childValues_;
-  std::string document_;
-  std::string indentString_;
-  int rightMargin_;
-  int indentSize_;
-  bool addChildValues_;
+  Formatter formatter_;
 };
 
 /** \brief Writes a Value in <a HREF="http://www.json.org">JSON</a> format in a
@@ -305,28 +476,7 @@ public:
   void write(std::ostream& out, const Value& root);
 
 private:
-  void writeValue(const Value& value);
-  void writeArrayValue(const Value& value);
-  bool isMultineArray(const Value& value);
-  void pushValue(const std::string& value);
-  void writeIndent();
-  void writeWithIndent(const std::string& value);
-  void indent();
-  void unindent();
-  void writeCommentBeforeValue(const Value& root);
-  void writeCommentAfterValueOnSameLine(const Value& root);
-  bool hasCommentForValue(const Value& value);
-  static std::string normalizeEOL(const std::string& text);
-
-  typedef std::vector<std::string> ChildValues;
-
-  ChildValues childValues_;
-  std::ostream* document_;
-  std::string indentString_;
-  int rightMargin_;
-  std::string indentation_;
-  bool addChildValues_ : 1;
-  bool indented_ : 1;
+  Formatter formatter_;
 };
 
 #if defined(JSON_HAS_INT64)
@@ -0,0 +1,240 @@
+// Copyright 2007-2011 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include <json/batch.h>
+#include "json_scanner.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstring>
+
+#if JSON_HAS_STD_THREAD
+#include <exception>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace Json {
+
+// Implementation of struct BatchResult
+// ////////////////////////////////
+
+BatchResult::BatchResult()
+    : ok(false), root(), offset(0), line(0), errors(), errorMessages() {}
+
+// Implementation of class BatchReader
+// ////////////////////////////////
+
+BatchReader::BatchReader()
+    : features_(Features::all()), threadCount_(0), keyTable_() {}
+
+BatchReader::BatchReader(const Features& features, unsigned int threadCount)
+    : features_(features), threadCount_(threadCount), keyTable_() {}
+
+void BatchReader::setKeyTable(KeyTable* keyTable) { keyTable_ = keyTable; }
+
+bool BatchReader::parseLines(const char* beginDoc,
+                             const char* endDoc,
+                             std::vector<BatchResult>& results,
+                             bool collectComments) {
+  std::vector<Job> jobs;
+  size_t line = 0;
+  for (const char* begin = beginDoc; begin != endDoc;) {
+    ++line;
+    const char* newline =
+        static_cast<const char*>(memchr(begin, '\n', endDoc - begin));
+    const char* next = newline ? newline + 1 : endDoc;
+    const char* end = newline ? newline : endDoc;
+    if (end != begin && end[-1] == '\r')
+      --end;
+    if (scanSpaces(begin, end) != end) {
+      Job job;
+      job.begin_ = begin;
+      job.end_ = end;
+      job.path_ = 0;
+      job.offset_ = size_t(begin - beginDoc);
+      job.line_ = line;
+      jobs.push_back(job);
+    }
+    begin = next;
+  }
+  return run(jobs, results, collectComments);
+}
+
+bool BatchReader::parseLines(const std::string& document,
+                             std::vector<BatchResult>& results,
+                             bool collectComments) {
+  const char* begin = document.data();
+  return parseLines(begin, begin + document.size(), results, collectComments);
+}
+
+bool BatchReader::parseFiles(const std::vector<std::string>& paths,
+                             std::vector<BatchResult>& results,
+                             bool collectComments) {
+  std::vector<Job> jobs(paths.size());
+  for (size_t index = 0; index < paths.size(); ++index) {
+    jobs[index].begin_ = 0;
+    jobs[index].end_ = 0;
+    jobs[index].path_ = &paths[index];
+    jobs[index].offset_ = 0;
+    jobs[index].line_ = 0;
+  }
+  return run(jobs, results, collectComments);
+}
+
+void BatchReader::parseJob(Reader& reader,
+                           const Job& job,
+                           BatchResult& result,
+                           bool collectComments) {
+  if (job.path_)
+    result.ok = reader.parseFile(*job.path_, result.root, collectComments);
+  else
+    result.ok =
+        reader.parse(job.begin_, job.end_, result.root, collectComments);
+  result.offset = job.offset_;
+  result.line = job.line_;
+  if (!result.ok) {
+    result.errors = reader.getStructuredErrors();
+    result.errorMessages = reader.getFormattedErrorMessages();
+  }
+}
+
+#if JSON_HAS_STD_THREAD
+
+namespace {
+
+/* Jobs left to a worker, [next, end) in input order. The owner takes jobs
+ * from the front, thieves take the back half. A mutex per worker is enough
+ * here: a job is a whole document, so the lock is never contended for long.
+ */
+struct WorkRange {
+  WorkRange() : next(0), end(0) {}
+
+  std::mutex mutex;
+  size_t next;
+  size_t end;
+};
+
+bool takeJob(WorkRange& range, size_t& job) {
+  std::lock_guard<std::mutex> lock(range.mutex);
+  if (range.next == range.end)
+    return false;
+  job = range.next++;
+  return true;
+}
+
+/// Moves the back half of the largest other range to \a self.
+/// \return \c false once every range is empty.
+bool stealJobs(std::vector<WorkRange>& ranges, size_t self) {
+  for (;;) {
+    size_t victim = self;
+    size_t largest = 0;
+    for (size_t index = 0; index < ranges.size(); ++index) {
+      if (index == self)
+        continue;
+      std::lock_guard<std::mutex> lock(ranges[index].mutex);
+      if (ranges[index].end - ranges[index].next > largest) {
+        largest = ranges[index].end - ranges[index].next;
+        victim = index;
+      }
+    }
+    if (victim == self)
+      return false;
+
+    size_t begin, end;
+    {
+      std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+      WorkRange& range = ranges[victim];
+      if (range.next == range.end)
+        continue; // emptied meanwhile, look again
+      begin = range.next + (range.end - range.next) / 2;
+      end = range.end;
+      range.end = begin;
+    }
+    std::lock_guard<std::mutex> lock(ranges[self].mutex);
+    ranges[self].next = begin;
+    ranges[self].end = end;
+    return true;
+  }
+}
+
+} // namespace
+
+#endif // if JSON_HAS_STD_THREAD
+
+bool BatchReader::run(const std::vector<Job>& jobs,
+                      std::vector<BatchResult>& results,
+                      bool collectComments) const {
+  results.clear();
+  results.resize(jobs.size());
+
+  size_t threadCount = 1;
+#if JSON_HAS_STD_THREAD
+  threadCount =
+      threadCount_ ? threadCount_ : std::thread::hardware_concurrency();
+  if (threadCount == 0)
+    threadCount = 1;
+  if (threadCount > jobs.size())
+    threadCount = jobs.size();
+#endif
+
+  if (threadCount <= 1) {
+    Reader reader(features_);
+    reader.setKeyTable(keyTable_);
+    for (size_t index = 0; index < jobs.size(); ++index)
+      parseJob(reader, jobs[index], results[index], collectComments);
+  }
+#if JSON_HAS_STD_THREAD
+  else {
+    std::vector<WorkRange> ranges(threadCount);
+    for (size_t index = 0; index < threadCount; ++index) {
+      ranges[index].next = jobs.size() * index / threadCount;
+      ranges[index].end = jobs.size() * (index + 1) / threadCount;
+    }
+
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+    auto work = [&](size_t self) {
+      try {
+        Reader reader(features_);
+        reader.setKeyTable(keyTable_);
+        size_t job;
+        do {
+          while (takeJob(ranges[self], job))
+            parseJob(reader, jobs[job], results[job], collectComments);
+        } while (stealJobs(ranges, self));
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        if (!failure)
+          failure = std::current_exception();
+      }
+    };
+
+    // The calling thread is worker 0. If a thread can not be started, the
+    // running workers steal its range, and worker 0 always runs: every job
+    // gets done and every started thread is joined.
+    std::vector<std::thread> threads;
+    try {
+      threads.reserve(threadCount - 1);
+      for (size_t self = 1; self < threadCount; ++self)
+        threads.push_back(std::thread(work, self));
+    } catch (const std::exception&) {
+      // std::system_error: go on with the threads already started.
+    }
+    work(0);
+    for (size_t index = 0; index < threads.size(); ++index)
+      threads[index].join();
+    if (failure)
+      std::rethrow_exception(failure);
+  }
+#endif
+
+  for (size_t index = 0; index < results.size(); ++index) {
+    if (!results[index].ok)
+      return false;
+  }
+  return true;
+}
+
+} // namespace Json
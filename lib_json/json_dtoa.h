@@ -0,0 +1,473 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef LIB_JSONCPP_JSON_DTOA_H_INCLUDED
+#define LIB_JSONCPP_JSON_DTOA_H_INCLUDED
+
+/* This header provides a locale independent conversion from a double to the
+ * shortest decimal string that reads back as the same double, written
+ * straight into a caller buffer.
+ *
+ * It implements Florian Loitsch's Grisu2 algorithm ("Printing Floating-Point
+ * Numbers Quickly and Accurately with Integers", PLDI 2010): the boundaries
+ * of the rounding interval of the double are scaled by a cached power of
+ * ten into 64-bit fixed point numbers, and digits are generated until the
+ * result is inside the interval. The scaling is off by up to one unit, so
+ * Grisu2 alone stays inside a slightly narrower interval, and for about
+ * 0.1% of the doubles misses a string one digit shorter near its bounds.
+ * As in Grisu3, digits are also generated for the slightly wider interval:
+ * when that gives a shorter string, the candidates of that length are read
+ * back with the in-tree parser of json_strtod.h to keep the one that is
+ * exact.
+ *
+ * It is an internal header that must not be exposed.
+ */
+
+#include "json_strtod.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+namespace Json {
+
+enum {
+  /// Size of the buffer that must be passed to doubleToChars(): sign, 17
+  /// digits, decimal point and exponent, or up to 4 leading zeros.
+  doubleToCharsBufferSize = 32
+};
+
+/// Floating point number f * 2^e, with a 64-bit significand.
+struct DiyFp {
+  DiyFp(UInt64 f, int e) : f_(f), e_(e) {}
+
+  UInt64 f_;
+  int e_;
+};
+
+/// x - y, for x >= y with the same exponent.
+static inline DiyFp diyFpSub(const DiyFp& x, const DiyFp& y) {
+  assert(x.e_ == y.e_ && x.f_ >= y.f_);
+  return DiyFp(x.f_ - y.f_, x.e_);
+}
+
+/// x * y, the 128-bit product rounded to its upper 64 bits.
+static inline DiyFp diyFpMul(const DiyFp& x, const DiyFp& y) {
+  const UInt64 xLow = x.f_ & 0xFFFFFFFFu;
+  const UInt64 xHigh = x.f_ >> 32;
+  const UInt64 yLow = y.f_ & 0xFFFFFFFFu;
+  const UInt64 yHigh = y.f_ >> 32;
+  const UInt64 lowLow = xLow * yLow;
+  const UInt64 lowHigh = xLow * yHigh;
+  const UInt64 highLow = xHigh * yLow;
+  const UInt64 highHigh = xHigh * yHigh;
+  UInt64 middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFFu) +
+                  (highLow & 0xFFFFFFFFu) + (UInt64(1) << 31); // rounding
+  return DiyFp(highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32),
+               x.e_ + y.e_ + 64);
+}
+
+/// x shifted left until its most significant bit is set.
+static inline DiyFp diyFpNormalize(DiyFp x) {
+  assert(x.f_ != 0);
+  while ((x.f_ >> 63) == 0) {
+    x.f_ <<= 1;
+    --x.e_;
+  }
+  return x;
+}
+
+/// x shifted left to the exponent \a e, which must not lose bits.
+static inline DiyFp diyFpNormalizeTo(const DiyFp& x, int e) {
+  assert(x.e_ >= e);
+  return DiyFp(x.f_ << (x.e_ - e), e);
+}
+
+/// 10^k_ ~= f_ * 2^e_, f_ rounded to 64 bits.
+struct CachedPower {
+  UInt64 f_;
+  int e_;
+  int k_;
+};
+
+/// Every eighth power of ten, from 10^-348 to 10^340. Generated with
+/// exact rational arithmetic.
+static const CachedPower cachedPowers[] = {
+    {0xfa8fd5a0081c0288ULL, -1220, -348},
+    {0xbaaee17fa23ebf76ULL, -1193, -340},
+    {0x8b16fb203055ac76ULL, -1166, -332},
+    {0xcf42894a5dce35eaULL, -1140, -324},
+    {0x9a6bb0aa55653b2dULL, -1113, -316},
+    {0xe61acf033d1a45dfULL, -1087, -308},
+    {0xab70fe17c79ac6caULL, -1060, -300},
+    {0xff77b1fcbebcdc4fULL, -1034, -292},
+    {0xbe5691ef416bd60cULL, -1007, -284},
+    {0x8dd01fad907ffc3cULL, -980, -276},
+    {0xd3515c2831559a83ULL, -954, -268},
+    {0x9d71ac8fada6c9b5ULL, -927, -260},
+    {0xea9c227723ee8bcbULL, -901, -252},
+    {0xaecc49914078536dULL, -874, -244},
+    {0x823c12795db6ce57ULL, -847, -236},
+    {0xc21094364dfb5637ULL, -821, -228},
+    {0x9096ea6f3848984fULL, -794, -220},
+    {0xd77485cb25823ac7ULL, -768, -212},
+    {0xa086cfcd97bf97f4ULL, -741, -204},
+    {0xef340a98172aace5ULL, -715, -196},
+    {0xb23867fb2a35b28eULL, -688, -188},
+    {0x84c8d4dfd2c63f3bULL, -661, -180},
+    {0xc5dd44271ad3cdbaULL, -635, -172},
+    {0x936b9fcebb25c996ULL, -608, -164},
+    {0xdbac6c247d62a584ULL, -582, -156},
+    {0xa3ab66580d5fdaf6ULL, -555, -148},
+    {0xf3e2f893dec3f126ULL, -529, -140},
+    {0xb5b5ada8aaff80b8ULL, -502, -132},
+    {0x87625f056c7c4a8bULL, -475, -124},
+    {0xc9bcff6034c13053ULL, -449, -116},
+    {0x964e858c91ba2655ULL, -422, -108},
+    {0xdff9772470297ebdULL, -396, -100},
+    {0xa6dfbd9fb8e5b88fULL, -369, -92},
+    {0xf8a95fcf88747d94ULL, -343, -84},
+    {0xb94470938fa89bcfULL, -316, -76},
+    {0x8a08f0f8bf0f156bULL, -289, -68},
+    {0xcdb02555653131b6ULL, -263, -60},
+    {0x993fe2c6d07b7facULL, -236, -52},
+    {0xe45c10c42a2b3b06ULL, -210, -44},
+    {0xaa242499697392d3ULL, -183, -36},
+    {0xfd87b5f28300ca0eULL, -157, -28},
+    {0xbce5086492111aebULL, -130, -20},
+    {0x8cbccc096f5088ccULL, -103, -12},
+    {0xd1b71758e219652cULL, -77, -4},
+    {0x9c40000000000000ULL, -50, 4},
+    {0xe8d4a51000000000ULL, -24, 12},
+    {0xad78ebc5ac620000ULL, 3, 20},
+    {0x813f3978f8940984ULL, 30, 28},
+    {0xc097ce7bc90715b3ULL, 56, 36},
+    {0x8f7e32ce7bea5c70ULL, 83, 44},
+    {0xd5d238a4abe98068ULL, 109, 52},
+    {0x9f4f2726179a2245ULL, 136, 60},
+    {0xed63a231d4c4fb27ULL, 162, 68},
+    {0xb0de65388cc8ada8ULL, 189, 76},
+    {0x83c7088e1aab65dbULL, 216, 84},
+    {0xc45d1df942711d9aULL, 242, 92},
+    {0x924d692ca61be758ULL, 269, 100},
+    {0xda01ee641a708deaULL, 295, 108},
+    {0xa26da3999aef774aULL, 322, 116},
+    {0xf209787bb47d6b85ULL, 348, 124},
+    {0xb454e4a179dd1877ULL, 375, 132},
+    {0x865b86925b9bc5c2ULL, 402, 140},
+    {0xc83553c5c8965d3dULL, 428, 148},
+    {0x952ab45cfa97a0b3ULL, 455, 156},
+    {0xde469fbd99a05fe3ULL, 481, 164},
+    {0xa59bc234db398c25ULL, 508, 172},
+    {0xf6c69a72a3989f5cULL, 534, 180},
+    {0xb7dcbf5354e9beceULL, 561, 188},
+    {0x88fcf317f22241e2ULL, 588, 196},
+    {0xcc20ce9bd35c78a5ULL, 614, 204},
+    {0x98165af37b2153dfULL, 641, 212},
+    {0xe2a0b5dc971f303aULL, 667, 220},
+    {0xa8d9d1535ce3b396ULL, 694, 228},
+    {0xfb9b7cd9a4a7443cULL, 720, 236},
+    {0xbb764c4ca7a44410ULL, 747, 244},
+    {0x8bab8eefb6409c1aULL, 774, 252},
+    {0xd01fef10a657842cULL, 800, 260},
+    {0x9b10a4e5e9913129ULL, 827, 268},
+    {0xe7109bfba19c0c9dULL, 853, 276},
+    {0xac2820d9623bf429ULL, 880, 284},
+    {0x80444b5e7aa7cf85ULL, 907, 292},
+    {0xbf21e44003acdd2dULL, 933, 300},
+    {0x8e679c2f5e44ff8fULL, 960, 308},
+    {0xd433179d9c8cb841ULL, 986, 316},
+    {0x9e19db92b4e31ba9ULL, 1013, 324},
+    {0xeb96bf6ebadf77d9ULL, 1039, 332},
+    {0xaf87023b9bf0ee6bULL, 1066, 340},
+};
+
+enum {
+  cachedPowersMinK = -348,
+  cachedPowersStepK = 8,
+  // Binary exponents of the scaled numbers, so that their integral part
+  // fits in 32 bits and digits can be produced from the fraction with
+  // 64-bit arithmetic.
+  grisuAlpha = -60,
+  grisuGamma = -32
+};
+
+/// Cached power of ten c such that w * c has an exponent in
+/// [grisuAlpha, grisuGamma], for a normalized w of exponent \a e.
+static inline const CachedPower& cachedPowerFor(int e) {
+  // k = ceil((alpha - e - 1) * log10(2)); 78913 / 2^18 ~= log10(2), and
+  // integer division truncates toward zero, which is the ceiling for
+  // negative values.
+  const int f = grisuAlpha - e - 1;
+  const int k = (f * 78913) / (1 << 18) + (f > 0);
+  const int index =
+      (k - cachedPowersMinK + cachedPowersStepK - 1) / cachedPowersStepK;
+  const CachedPower& cached = cachedPowers[index];
+  assert(grisuAlpha <= cached.e_ + e + 64 && cached.e_ + e + 64 <= grisuGamma);
+  return cached;
+}
+
+/// Number of decimal digits of \a n, and the power of ten of the first one.
+static inline int decimalLength(UInt n, UInt& power) {
+  static const UInt powers[] = {1u,         10u,        100u,
+                                1000u,      10000u,     100000u,
+                                1000000u,   10000000u,  100000000u,
+                                1000000000u};
+  int length = 10;
+  while (length > 1 && n < powers[length - 1])
+    --length;
+  power = powers[length - 1];
+  return length;
+}
+
+/// Moves the last digit toward w while it stays in the interval, so that
+/// the result is the closest to w of the candidates of that length.
+static inline void grisuRound(char* digits,
+                              int length,
+                              UInt64 distance,
+                              UInt64 delta,
+                              UInt64 rest,
+                              UInt64 tenK) {
+  while (rest < distance && delta - rest >= tenK &&
+         (rest + tenK < distance || distance - rest > rest + tenK - distance)) {
+    --digits[length - 1];
+    rest += tenK;
+  }
+}
+
+/// Generates the shortest digits of a number in [low, high], as close as
+/// possible to w. All three are scaled with an exponent in [grisuAlpha,
+/// grisuGamma]. The number is digits * 10^exponent. \a nearBound is set if
+/// moving low and high out by 2 units might have given fewer digits.
+static inline void grisuDigits(const DiyFp& low,
+                               const DiyFp& w,
+                               const DiyFp& high,
+                               char* digits,
+                               int& length,
+                               int& exponent,
+                               bool& nearBound) {
+  UInt64 delta = diyFpSub(high, low).f_;
+  UInt64 distance = diyFpSub(high, w).f_;
+  // one = 2^-e: high = integral * one + fraction.
+  const int shift = -high.e_;
+  const UInt64 one = UInt64(1) << shift;
+  UInt integral = UInt(high.f_ >> shift);
+  UInt64 fraction = high.f_ & (one - 1);
+  nearBound = false;
+
+  UInt power;
+  int remaining = decimalLength(integral, power);
+  while (remaining > 0) {
+    digits[length++] = char('0' + integral / power);
+    integral %= power;
+    --remaining;
+    const UInt64 rest = (UInt64(integral) << shift) + fraction;
+    if (rest <= delta) {
+      // The digits so far, followed by zeros, are in the interval.
+      exponent += remaining;
+      grisuRound(
+          digits, length, distance, delta, rest, UInt64(power) << shift);
+      return;
+    }
+    if (rest - delta <= 2 || (UInt64(power) << shift) - rest <= 2)
+      nearBound = true;
+    power /= 10;
+  }
+
+  // The integral part was not enough: go on with the fraction. delta and
+  // distance are scaled along with it, and so is the unit of the bounds.
+  UInt64 unit = 1;
+  for (;;) {
+    fraction *= 10;
+    delta *= 10;
+    distance *= 10;
+    unit *= 10;
+    digits[length++] = char('0' + (fraction >> shift));
+    fraction &= one - 1;
+    --exponent;
+    if (fraction <= delta)
+      break;
+    if (fraction - delta <= 2 * unit || one - fraction <= 2 * unit)
+      nearBound = true;
+  }
+  grisuRound(digits, length, distance, delta, fraction, one);
+}
+
+/// Shortest digits of a positive finite \a value in its rounding interval,
+/// narrowed by \a margin units of the scaled bounds, or widened for a
+/// negative margin: value ~= digits * 10^exponent, with at most 17 digits.
+static inline void grisu2(double value, int margin, char* digits,
+                          int& length, int& exponent, bool& nearBound) {
+  UInt64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const UInt64 hiddenBit = UInt64(1) << 52;
+  const UInt64 fractionBits = bits & (hiddenBit - 1);
+  const int biasedExponent = int(bits >> 52) & 0x7FF;
+
+  // value = v.f * 2^v.e, and the rounding interval of value is [low, high]:
+  // halfway to its neighbours, closer below at powers of two.
+  const DiyFp v = biasedExponent == 0
+                      ? DiyFp(fractionBits, 1 - 1075)
+                      : DiyFp(fractionBits | hiddenBit, biasedExponent - 1075);
+  const bool lowerIsCloser = fractionBits == 0 && biasedExponent > 1;
+  const DiyFp high = diyFpNormalize(DiyFp(2 * v.f_ + 1, v.e_ - 1));
+  const DiyFp low = diyFpNormalizeTo(
+      lowerIsCloser ? DiyFp(4 * v.f_ - 1, v.e_ - 2)
+                    : DiyFp(2 * v.f_ - 1, v.e_ - 1),
+      high.e_);
+  const DiyFp w = diyFpNormalize(v);
+
+  const CachedPower& cached = cachedPowerFor(high.e_);
+  const DiyFp power(cached.f_, cached.e_);
+  const DiyFp scaledW = diyFpMul(w, power);
+  DiyFp scaledLow = diyFpMul(low, power);
+  DiyFp scaledHigh = diyFpMul(high, power);
+  // The products are off by up to one unit: with a margin of 1, the bounds
+  // are safely inside the interval, with -1 safely outside of it.
+  scaledLow.f_ += margin;
+  scaledHigh.f_ -= margin;
+
+  length = 0;
+  exponent = -cached.k_;
+  grisuDigits(
+      scaledLow, scaledW, scaledHigh, digits, length, exponent, nearBound);
+}
+
+/// \c true if digits * 10^exponent reads back as \a value.
+static inline bool readsBackAs(const char* digits, int length, int exponent,
+                               double value) {
+  char text[40];
+  memcpy(text, digits, length);
+  char* end = text + length;
+  end += sprintf(end, "e%d", exponent);
+  double parsed;
+  return parseDouble(text, end, parsed) && parsed == value;
+}
+
+/// Adds \a step (1 or -1) to the last digit of digits * 10^exponent, and
+/// drops the zeros that leaves on either side.
+static inline void stepLastDigit(char* digits, int& length, int& exponent,
+                                 int step) {
+  int index = length - 1;
+  const char wrapFrom = step > 0 ? '9' : '0';
+  while (index >= 0 && digits[index] == wrapFrom)
+    digits[index--] = step > 0 ? '0' : '9';
+  if (index < 0) {
+    // 99 + 1: one more digit in front.
+    memmove(digits + 1, digits, length++);
+    digits[0] = '1';
+  } else {
+    digits[index] = char(digits[index] + step);
+  }
+  if (digits[0] == '0') {
+    // 100 - 1
+    memmove(digits, digits + 1, --length);
+  }
+  while (length > 1 && digits[length - 1] == '0') {
+    --length;
+    ++exponent;
+  }
+}
+
+/// Shortest digits of a positive finite \a value: value ~= digits *
+/// 10^exponent, with at most 17 digits.
+static inline void shortestDigits(double value, char* digits, int& length,
+                                  int& exponent) {
+  bool nearBound;
+  grisu2(value, 1, digits, length, exponent, nearBound);
+  if (!nearBound)
+    return; // No shorter string can be in the interval.
+  char wide[20];
+  int wideLength;
+  int wideExponent;
+  grisu2(value, -1, wide, wideLength, wideExponent, nearBound);
+  if (wideLength >= length)
+    return;
+
+  // The closest candidate to value of that length, or one of its
+  // neighbours, is in the interval if any is.
+  for (int step = 0; step != 3; ++step) {
+    char candidate[20];
+    int candidateLength = wideLength;
+    int candidateExponent = wideExponent;
+    memcpy(candidate, wide, wideLength);
+    if (step != 0)
+      stepLastDigit(
+          candidate, candidateLength, candidateExponent, step == 1 ? -1 : 1);
+    if (candidateLength != 0 && candidateLength < length &&
+        readsBackAs(candidate, candidateLength, candidateExponent, value)) {
+      memcpy(digits, candidate, candidateLength);
+      length = candidateLength;
+      exponent = candidateExponent;
+      return;
+    }
+  }
+}
+
+/** Writes the shortest representation of a finite \a value to \a buffer,
+ * laid out like printf's "%.17g": plain decimal notation for decimal
+ * exponents in [-5, 17), else "d.ddde+XX". The buffer must have
+ * doubleToCharsBufferSize chars free; no null terminator is written.
+ * \return The end of the written characters.
+ */
+static inline char* doubleToChars(double value, char* buffer) {
+  char* current = buffer;
+  if (value < 0 || (value == 0 && 1 / value < 0)) {
+    *current++ = '-';
+    value = -value;
+  }
+  if (value == 0) {
+    *current++ = '0';
+    return current;
+  }
+
+  char digits[20];
+  int length;
+  int exponent;
+  shortestDigits(value, digits, length, exponent);
+
+  // Exponent of the first digit, as in d.ddd * 10^scientific.
+  const int scientific = length + exponent - 1;
+  if (scientific < -4 || scientific >= 17) {
+    *current++ = digits[0];
+    if (length > 1) {
+      *current++ = '.';
+      memcpy(current, digits + 1, length - 1);
+      current += length - 1;
+    }
+    *current++ = 'e';
+    *current++ = scientific < 0 ? '-' : '+';
+    int magnitude = scientific < 0 ? -scientific : scientific;
+    if (magnitude >= 100)
+      *current++ = char('0' + magnitude / 100);
+    *current++ = char('0' + magnitude / 10 % 10);
+    *current++ = char('0' + magnitude % 10);
+  } else if (exponent >= 0) {
+    // Integral: ddd000.
+    memcpy(current, digits, length);
+    current += length;
+    memset(current, '0', exponent);
+    current += exponent;
+  } else if (scientific >= 0) {
+    // ddd.ddd
+    memcpy(current, digits, scientific + 1);
+    current += scientific + 1;
+    *current++ = '.';
+    memcpy(current, digits + scientific + 1, length - scientific - 1);
+    current += length - scientific - 1;
+  } else {
+    // 0.000ddd
+    *current++ = '0';
+    *current++ = '.';
+    memset(current, '0', -scientific - 1);
+    current += -scientific - 1;
+    memcpy(current, digits, length);
+    current += length;
+  }
+  return current;
+}
+
+} // namespace Json
+
+#endif // LIB_JSONCPP_JSON_DTOA_H_INCLUDED
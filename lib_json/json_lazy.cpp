@@ -0,0 +1,387 @@
+// Copyright 2007-2011 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include <json/assertions.h>
+#include <json/lazy.h>
+#include <json/value.h>
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <algorithm>
+#include <cstring>
+
+namespace Json {
+
+// Implementation of class LazyDocument
+// ////////////////////////////////
+
+LazyDocument::LazyDocument() : sax_(), pool_(), tape_(), open_() {}
+
+LazyDocument::LazyDocument(const Features& features)
+    : sax_(features), pool_(), tape_(), open_() {}
+
+bool LazyDocument::parse(const char* beginDoc, const char* endDoc) {
+  clear();
+  return endDocument(sax_.parse(beginDoc, endDoc, *this, false));
+}
+
+bool LazyDocument::parse(const std::string& document) {
+  clear();
+  return endDocument(sax_.parse(document, *this, false));
+}
+
+bool LazyDocument::parse(std::istream& sin) {
+  clear();
+  return endDocument(sax_.parse(sin, *this, false));
+}
+
+bool LazyDocument::parseFile(const std::string& path) {
+  clear();
+  return endDocument(sax_.parseFile(path, *this, false));
+}
+
+#if defined(_WIN32)
+bool LazyDocument::parseFile(const std::wstring& path) {
+  clear();
+  return endDocument(sax_.parseFile(path, *this, false));
+}
+#endif
+
+void LazyDocument::clear() {
+  pool_.clear();
+  tape_.clear();
+  open_.clear();
+}
+
+bool LazyDocument::endDocument(bool successful) {
+  // A partial tape can not be navigated safely: containers left open by the
+  // error have no end index.
+  if (!successful)
+    clear();
+  return successful;
+}
+
+LazyValue LazyDocument::root() const {
+  if (tape_.empty())
+    return LazyValue();
+  return LazyValue(this, 0);
+}
+
+std::string LazyDocument::getFormattedErrorMessages() const {
+  return sax_.getFormattedErrorMessages();
+}
+
+std::vector<LazyDocument::StructuredError>
+LazyDocument::getStructuredErrors() const {
+  return sax_.getStructuredErrors();
+}
+
+bool LazyDocument::good() const { return sax_.good(); }
+
+LazyDocument::Node& LazyDocument::addValue(ValueType type) {
+  if (!open_.empty()) {
+    Node& parent = tape_[open_.back()];
+    // Object members are counted by onKey().
+    if (parent.type_ == arrayValue)
+      ++parent.size_;
+  }
+  tape_.push_back(Node());
+  Node& node = tape_.back();
+  node.type_ = static_cast<unsigned char>(type);
+  return node;
+}
+
+void LazyDocument::setText(Node& node, const char* begin, const char* end) {
+  node.size_ = ArrayIndex(end - begin);
+  // Text without escape sequences is passed as a range of the document and
+  // only needs to be referenced.
+  const char* beginDoc = sax_.getDocumentBegin();
+  if (begin >= beginDoc && end <= sax_.getDocumentEnd()) {
+    node.pooled_ = false;
+    node.value_.text_ = size_t(begin - beginDoc);
+  } else {
+    node.pooled_ = true;
+    node.value_.text_ = pool_.size();
+    pool_.append(begin, end);
+  }
+}
+
+void LazyDocument::beginContainer(ValueType type) {
+  size_t index = tape_.size();
+  addValue(type);
+  open_.push_back(index);
+}
+
+void LazyDocument::endContainer() {
+  tape_[open_.back()].value_.next_ = tape_.size();
+  open_.pop_back();
+}
+
+void LazyDocument::onNull() { addValue(nullValue); }
+
+void LazyDocument::onBool(bool value) {
+  addValue(booleanValue).value_.bool_ = value;
+}
+
+void LazyDocument::onInt(LargestInt value) {
+  addValue(intValue).value_.int_ = value;
+}
+
+void LazyDocument::onUInt(LargestUInt value) {
+  // Keep small values signed, like Reader.
+  if (value <= LargestUInt(Value::maxInt))
+    addValue(intValue).value_.int_ = LargestInt(value);
+  else
+    addValue(uintValue).value_.uint_ = value;
+}
+
+void LazyDocument::onDouble(double value) {
+  addValue(realValue).value_.real_ = value;
+}
+
+void LazyDocument::onString(const char* begin, const char* end) {
+  setText(addValue(stringValue), begin, end);
+}
+
+void LazyDocument::onObjectBegin() { beginContainer(objectValue); }
+
+void LazyDocument::onKey(const char* begin, const char* end) {
+  ++tape_[open_.back()].size_;
+  tape_.push_back(Node());
+  Node& node = tape_.back();
+  node.type_ = keyNode;
+  setText(node, begin, end);
+}
+
+void LazyDocument::onObjectEnd() { endContainer(); }
+
+void LazyDocument::onArrayBegin() { beginContainer(arrayValue); }
+
+void LazyDocument::onArrayEnd() { endContainer(); }
+
+const char* LazyDocument::text(const Node& node) const {
+  if (node.pooled_)
+    return pool_.data() + node.value_.text_;
+  return sax_.getDocumentBegin() + node.value_.text_;
+}
+
+size_t LazyDocument::skip(size_t index) const {
+  const Node& node = tape_[index];
+  if (node.type_ == arrayValue || node.type_ == objectValue)
+    return node.value_.next_;
+  return index + 1;
+}
+
+void LazyDocument::materialize(size_t index, Value& value) const {
+  const Node& node = tape_[index];
+  switch (node.type_) {
+  case arrayValue: {
+    Value array(arrayValue);
+    value.swapPayload(array);
+    value.reserve(node.size_);
+    ArrayIndex element = 0;
+    for (size_t child = index + 1; child != node.value_.next_;
+         child = skip(child))
+      materialize(child, value[element++]);
+  } break;
+  case objectValue: {
+    Value object(objectValue);
+    value.swapPayload(object);
+    for (size_t child = index + 1; child != node.value_.next_;
+         child = skip(child + 1)) {
+      const char* key = text(tape_[child]);
+      materialize(child + 1,
+                  value.addMember(std::string(key, key + tape_[child].size_)));
+    }
+    value.sortMembers();
+  } break;
+  default: {
+    Value scalar = LazyValue(this, index).scalar();
+    value.swapPayload(scalar);
+  } break;
+  }
+}
+
+// Implementation of class LazyValue
+// ////////////////////////////////
+
+LazyValue::LazyValue() : document_(), index_() {}
+
+LazyValue::LazyValue(const LazyDocument* document, size_t index)
+    : document_(document), index_(index) {}
+
+ValueType LazyValue::type() const {
+  if (!document_)
+    return nullValue;
+  return ValueType(document_->tape_[index_].type_);
+}
+
+bool LazyValue::isNull() const { return type() == nullValue; }
+
+bool LazyValue::isBool() const { return type() == booleanValue; }
+
+bool LazyValue::isNumeric() const {
+  ValueType t = type();
+  return t == intValue || t == uintValue || t == realValue;
+}
+
+bool LazyValue::isString() const { return type() == stringValue; }
+
+bool LazyValue::isArray() const { return type() == arrayValue; }
+
+bool LazyValue::isObject() const { return type() == objectValue; }
+
+// Conversions go through a Value of the same type, so that they follow
+// exactly the rules (and failures) of Value. Containers convert like
+// empty ones, since no conversion looks at their content.
+Value LazyValue::scalar() const {
+  if (!document_)
+    return Value();
+  const LazyDocument::Node& node = document_->tape_[index_];
+  switch (node.type_) {
+  case intValue:
+    return Value(node.value_.int_);
+  case uintValue:
+    return Value(node.value_.uint_);
+  case realValue:
+    return Value(node.value_.real_);
+  case booleanValue:
+    return Value(node.value_.bool_);
+  case stringValue: {
+    const char* begin = document_->text(node);
+    return Value(begin, begin + node.size_);
+  }
+  default:
+    return Value(ValueType(node.type_));
+  }
+}
+
+std::string LazyValue::asString() const {
+  if (isString()) {
+    // Like Value, the string stops at the first embedded null character.
+    const LazyDocument::Node& node = document_->tape_[index_];
+    const char* begin = document_->text(node);
+    const char* end = static_cast<const char*>(memchr(begin, 0, node.size_));
+    return std::string(begin, end ? end : begin + node.size_);
+  }
+  return scalar().asString();
+}
+
+Int LazyValue::asInt() const { return scalar().asInt(); }
+
+UInt LazyValue::asUInt() const { return scalar().asUInt(); }
+
+#if defined(JSON_HAS_INT64)
+Int64 LazyValue::asInt64() const { return scalar().asInt64(); }
+
+UInt64 LazyValue::asUInt64() const { return scalar().asUInt64(); }
+#endif // if defined(JSON_HAS_INT64)
+
+LargestInt LazyValue::asLargestInt() const { return scalar().asLargestInt(); }
+
+LargestUInt LazyValue::asLargestUInt() const {
+  return scalar().asLargestUInt();
+}
+
+float LazyValue::asFloat() const { return scalar().asFloat(); }
+
+double LazyValue::asDouble() const { return scalar().asDouble(); }
+
+bool LazyValue::asBool() const { return scalar().asBool(); }
+
+ArrayIndex LazyValue::size() const {
+  if (isArray() || isObject())
+    return document_->tape_[index_].size_;
+  return 0;
+}
+
+bool LazyValue::empty() const {
+  if (isNull() || isArray() || isObject())
+    return size() == 0u;
+  else
+    return false;
+}
+
+LazyValue LazyValue::operator[](ArrayIndex index) const {
+  JSON_ASSERT_MESSAGE(
+      isNull() || isArray(),
+      "in Json::LazyValue::operator[](ArrayIndex)const: requires arrayValue");
+  if (isNull() || index >= size())
+    return LazyValue();
+  size_t child = index_ + 1;
+  for (; index != 0; --index)
+    child = document_->skip(child);
+  return LazyValue(document_, child);
+}
+
+LazyValue LazyValue::operator[](int index) const {
+  JSON_ASSERT_MESSAGE(
+      index >= 0,
+      "in Json::LazyValue::operator[](int index) const: index cannot be "
+      "negative");
+  return (*this)[ArrayIndex(index)];
+}
+
+size_t LazyValue::find(const char* key, size_t length) const {
+  const LazyDocument::Node& object = document_->tape_[index_];
+  size_t found = 0;
+  for (size_t child = index_ + 1; child != object.value_.next_;
+       child = document_->skip(child + 1)) {
+    const LazyDocument::Node& name = document_->tape_[child];
+    if (name.size_ == length &&
+        memcmp(document_->text(name), key, length) == 0)
+      found = child + 1;
+  }
+  return found;
+}
+
+LazyValue LazyValue::operator[](const char* key) const {
+  JSON_ASSERT_MESSAGE(
+      isNull() || isObject(),
+      "in Json::LazyValue::operator[](char const*)const: requires objectValue");
+  if (isNull())
+    return LazyValue();
+  size_t found = find(key, strlen(key));
+  return found ? LazyValue(document_, found) : LazyValue();
+}
+
+LazyValue LazyValue::operator[](const std::string& key) const {
+  return (*this)[key.c_str()];
+}
+
+bool LazyValue::isMember(const char* key) const {
+  return isObject() && find(key, strlen(key)) != 0;
+}
+
+bool LazyValue::isMember(const std::string& key) const {
+  return isMember(key.c_str());
+}
+
+Value::Members LazyValue::getMemberNames() const {
+  JSON_ASSERT_MESSAGE(
+      isNull() || isObject(),
+      "in Json::LazyValue::getMemberNames(), value must be objectValue");
+  Value::Members members;
+  if (isNull())
+    return members;
+  const LazyDocument::Node& object = document_->tape_[index_];
+  members.reserve(object.size_);
+  for (size_t child = index_ + 1; child != object.value_.next_;
+       child = document_->skip(child + 1)) {
+    const LazyDocument::Node& name = document_->tape_[child];
+    members.push_back(std::string(document_->text(name), name.size_));
+  }
+  std::sort(members.begin(), members.end());
+  members.erase(std::unique(members.begin(), members.end()), members.end());
+  return members;
+}
+
+Value LazyValue::materialize() const {
+  Value value;
+  if (document_)
+    document_->materialize(index_, value);
+  return value;
+}
+
+} // namespace Json
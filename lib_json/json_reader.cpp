@@ -5,10 +5,16 @@
 
 #if !defined(JSON_IS_AMALGAMATION)
 #include <json/assertions.h>
+#include <json/keytable.h>
 #include <json/reader.h>
 #include <json/value.h>
 #include "json_tool.h"
+#include "json_scanner.h"
+#if defined(JSON_HAS_INT64)
+#include "json_strtod.h"
+#endif
 #endif // if !defined(JSON_IS_AMALGAMATION)
+#include <algorithm>
 #include <utility>
 #include <cstdio>
 #include <cassert>
@@ -16,6 +22,23 @@
 #include <istream>
 #include <sstream>
 #include <memory>
+#include <iterator>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #if defined(_MSC_VER) && _MSC_VER < 1500 // VC++ 8.0 and below
 #define snprintf _snprintf
@@ -39,7 +62,8 @@ typedef std::auto_ptr<CharReader>   CharReaderPtr;
 
 Features::Features()
     : allowComments_(true), strictRoot_(false),
-      allowDroppedNullPlaceholders_(false), allowNumericKeys_(false) {}
+      allowDroppedNullPlaceholders_(false), allowNumericKeys_(false),
+      validateUTF8_(false) {}
 
 Features Features::all() { return Features(); }
 
@@ -49,80 +73,366 @@ Features Features::strictMode() {
   features.strictRoot_ = true;
   features.allowDroppedNullPlaceholders_ = false;
   features.allowNumericKeys_ = false;
+  features.validateUTF8_ = true;
   return features;
 }
 
-// Implementation of class Reader
+// Implementation of class MappedFile
+// ////////////////////////////////
+
+MappedFile::MappedFile()
+    : begin_(0), size_(0), isOpen_(false)
+#if defined(_WIN32)
+      ,
+      mapping_(0)
+#endif
+{
+}
+
+MappedFile::~MappedFile() { close(); }
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const char* path) {
+  close();
+  HANDLE file = ::CreateFileA(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              NULL,
+                              OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN,
+                              NULL);
+  return map(file);
+}
+
+bool MappedFile::open(const wchar_t* path) {
+  close();
+  HANDLE file = ::CreateFileW(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              NULL,
+                              OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN,
+                              NULL);
+  return map(file);
+}
+
+bool MappedFile::map(void* handle) {
+  HANDLE file = static_cast<HANDLE>(handle);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER fileSize;
+  if (!::GetFileSizeEx(file, &fileSize) ||
+      static_cast<unsigned long long>(fileSize.QuadPart) >
+          static_cast<size_t>(-1)) {
+    ::CloseHandle(file);
+    return false;
+  }
+  size_ = static_cast<size_t>(fileSize.QuadPart);
+  // An empty file cannot be mapped; it is still a valid (empty) document.
+  if (size_ != 0) {
+    HANDLE mapping =
+        ::CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping != NULL)
+      begin_ = static_cast<const char*>(
+          ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (begin_ == 0) {
+      if (mapping != NULL)
+        ::CloseHandle(mapping);
+      ::CloseHandle(file);
+      size_ = 0;
+      return false;
+    }
+    mapping_ = mapping;
+  }
+  // The view keeps the file referenced, the handle is no longer needed.
+  ::CloseHandle(file);
+  isOpen_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (begin_ != 0)
+    ::UnmapViewOfFile(begin_);
+  if (mapping_ != 0)
+    ::CloseHandle(static_cast<HANDLE>(mapping_));
+  begin_ = 0;
+  size_ = 0;
+  mapping_ = 0;
+  isOpen_ = false;
+}
+
+#else // if defined(_WIN32)
+
+bool MappedFile::open(const char* path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  return map(&fd);
+}
+
+bool MappedFile::map(void* handle) {
+  int fd = *static_cast<int*>(handle);
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      static_cast<unsigned long long>(st.st_size) > static_cast<size_t>(-1)) {
+    ::close(fd);
+    return false;
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  // mmap() refuses empty ranges; an empty file is still a valid (empty)
+  // document.
+  if (size_ != 0) {
+    void* addr = ::mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      ::close(fd);
+      size_ = 0;
+      return false;
+    }
+#if defined(MADV_SEQUENTIAL)
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+#endif
+    begin_ = static_cast<const char*>(addr);
+  }
+  // The mapping keeps the file referenced, the descriptor is no longer needed.
+  ::close(fd);
+  isOpen_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (begin_ != 0)
+    ::munmap(const_cast<char*>(begin_), size_);
+  begin_ = 0;
+  size_ = 0;
+  isOpen_ = false;
+}
+
+#endif // if defined(_WIN32)
+
+bool MappedFile::isOpen() const { return isOpen_; }
+
+const char* MappedFile::begin() const { return begin_; }
+
+const char* MappedFile::end() const { return begin_ + size_; }
+
+size_t MappedFile::size() const { return size_; }
+
+// Implementation of class SaxHandler
+// ////////////////////////////////
+
+SaxHandler::~SaxHandler() {}
+
+void SaxHandler::onNull() {}
+
+void SaxHandler::onBool(bool) {}
+
+void SaxHandler::onInt(LargestInt) {}
+
+void SaxHandler::onUInt(LargestUInt) {}
+
+void SaxHandler::onDouble(double) {}
+
+void SaxHandler::onString(const char*, const char*) {}
+
+void SaxHandler::onObjectBegin() {}
+
+void SaxHandler::onKey(const char*, const char*) {}
+
+void SaxHandler::onObjectEnd() {}
+
+void SaxHandler::onArrayBegin() {}
+
+void SaxHandler::onArrayEnd() {}
+
+void SaxHandler::onComment(const char*, const char*, CommentPlacement) {}
+
+// Implementation of class SaxReader
 // ////////////////////////////////
 
-static bool containsNewLine(Reader::Location begin, Reader::Location end) {
+static bool containsNewLine(SaxReader::Location begin,
+                            SaxReader::Location end) {
   for (; begin < end; ++begin)
     if (*begin == '\n' || *begin == '\r')
       return true;
   return false;
 }
 
-// Class Reader
-// //////////////////////////////////////////////////////////////////
-
-Reader::Reader()
-    : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(), features_(Features::all()),
-      collectComments_() {}
-
-Reader::Reader(const Features& features)
-    : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(), features_(features), collectComments_() {
+SaxReader::SaxReader()
+    : handler_(), errors_(), document_(), decoded_(), begin_(), end_(),
+      current_(), lastValueEnd_(), valueStart_(), valueLimit_(),
+      features_(Features::all()), collectComments_(), rootIsContainer_(),
+      paths_(), path_(-1) {}
+
+SaxReader::SaxReader(const Features& features)
+    : handler_(), errors_(), document_(), decoded_(), begin_(), end_(),
+      current_(), lastValueEnd_(), valueStart_(), valueLimit_(),
+      features_(features), collectComments_(), rootIsContainer_(), paths_(),
+      path_(-1) {}
+
+bool SaxReader::parse(const std::string& document,
+                      SaxHandler& handler,
+                      bool collectComments) {
+  document_ = document;
+  const char* begin = document_.c_str();
+  const char* end = begin + document_.length();
+  return parse(begin, end, handler, collectComments);
 }
 
 bool
-Reader::parse(const std::string& document, Value& root, bool collectComments) {
-  document_ = document;
-  const char* begin = document_.c_str();
+SaxReader::parse(std::istream& sin, SaxHandler& handler, bool collectComments) {
+  // Read the stream straight into document_ rather than through a temporary,
+  // so the text is copied only once. Callers that have a file on disk should
+  // prefer parseFile(), which avoids the copy entirely.
+  document_.assign(std::istreambuf_iterator<char>(sin),
+                   std::istreambuf_iterator<char>());
+  const char* begin = document_.data();
   const char* end = begin + document_.length();
-  return parse(begin, end, root, collectComments);
+  return parse(begin, end, handler, collectComments);
 }
 
-bool Reader::parse(std::istream& sin, Value& root, bool collectComments) {
-  // std::istream_iterator<char> begin(sin);
-  // std::istream_iterator<char> end;
-  // Those would allow streamed input from a file, if parse() were a
-  // template function.
+bool SaxReader::parseFile(const std::string& path,
+                          SaxHandler& handler,
+                          bool collectComments) {
+  return parseMappedFile(
+      mappedFile_.open(path.c_str()), path, handler, collectComments);
+}
 
-  // Since std::string is reference-counted, this at least does not
-  // create an extra copy.
-  std::string doc;
-  std::getline(sin, doc, (char)EOF);
-  return parse(doc, root, collectComments);
+#if defined(_WIN32)
+bool SaxReader::parseFile(const std::wstring& path,
+                          SaxHandler& handler,
+                          bool collectComments) {
+  return parseMappedFile(mappedFile_.open(path.c_str()),
+                         std::string(path.begin(), path.end()),
+                         handler,
+                         collectComments);
 }
+#endif
 
-bool Reader::parse(const char* beginDoc,
-                   const char* endDoc,
-                   Value& root,
-                   bool collectComments) {
+/// Decodes one reference token of a JSON Pointer, "~1" standing for '/' and
+/// "~0" for '~'.
+static bool decodePathKey(const std::string& pointer,
+                          size_t begin,
+                          size_t end,
+                          std::string& key) {
+  key.clear();
+  for (size_t index = begin; index != end; ++index) {
+    char c = pointer[index];
+    if (c == '~') {
+      if (++index == end || (pointer[index] != '0' && pointer[index] != '1'))
+        return false;
+      c = pointer[index] == '0' ? '~' : '/';
+    }
+    key += c;
+  }
+  return true;
+}
+
+/// Array index written by a reference token: digits without leading zeros.
+static ArrayIndex pathKeyIndex(const std::string& key) {
+  if (key.empty() || key.size() > 9 || (key[0] == '0' && key.size() != 1))
+    return ArrayIndex(-1);
+  ArrayIndex index = 0;
+  for (size_t i = 0; i < key.size(); ++i) {
+    if (!isJsonDigit(key[i]))
+      return ArrayIndex(-1);
+    index = index * 10 + ArrayIndex(key[i] - '0');
+  }
+  return index;
+}
+
+bool SaxReader::addPath(const std::string& pointer) {
+  if (!pointer.empty() && pointer[0] != '/')
+    return false;
+  std::vector<std::string> keys;
+  for (size_t begin = 1; begin <= pointer.size();) {
+    size_t end = pointer.find('/', begin);
+    if (end == std::string::npos)
+      end = pointer.size();
+    keys.push_back(std::string());
+    if (!decodePathKey(pointer, begin, end, keys.back()))
+      return false;
+    begin = end + 1;
+  }
+
+  if (paths_.empty()) {
+    PathNode root;
+    root.index_ = ArrayIndex(-1);
+    root.indexLimit_ = 0;
+    root.selected_ = false;
+    paths_.push_back(root);
+  }
+  int node = 0;
+  for (size_t k = 0; k < keys.size(); ++k) {
+    const std::string& key = keys[k];
+    int child = findPath(node, key.data(), key.data() + key.size());
+    if (child < 0) {
+      PathNode path;
+      path.key_ = key;
+      path.index_ = pathKeyIndex(key);
+      path.indexLimit_ = 0;
+      path.selected_ = false;
+      child = int(paths_.size());
+      paths_.push_back(path);
+      paths_[node].children_.push_back(child);
+      if (path.index_ != ArrayIndex(-1) &&
+          path.index_ >= paths_[node].indexLimit_)
+        paths_[node].indexLimit_ = path.index_ + 1;
+    }
+    node = child;
+  }
+  paths_[node].selected_ = true;
+  return true;
+}
+
+void SaxReader::clearPaths() { paths_.clear(); }
+
+bool SaxReader::hasPaths() const { return !paths_.empty(); }
+
+bool SaxReader::parseMappedFile(bool opened,
+                                const std::string& path,
+                                SaxHandler& handler,
+                                bool collectComments) {
+  // Drop any text kept alive for a previous parse.
+  document_.clear();
+  if (!opened) {
+    begin_ = end_ = current_ = document_.data();
+    errors_.clear();
+    Token token;
+    token.type_ = tokenError;
+    token.start_ = begin_;
+    token.end_ = end_;
+    addError("Unable to open file '" + path + "'.", token);
+    return false;
+  }
+  return parse(
+      mappedFile_.begin(), mappedFile_.end(), handler, collectComments);
+}
+
+bool SaxReader::parse(const char* beginDoc,
+                      const char* endDoc,
+                      SaxHandler& handler,
+                      bool collectComments) {
   if (!features_.allowComments_) {
     collectComments = false;
   }
 
+  handler_ = &handler;
   begin_ = beginDoc;
   end_ = endDoc;
   collectComments_ = collectComments;
   current_ = begin_;
   lastValueEnd_ = 0;
-  lastValue_ = 0;
-  commentsBefore_ = "";
+  rootIsContainer_ = false;
   errors_.clear();
-  while (!nodes_.empty())
-    nodes_.pop();
-  nodes_.push(&root);
+  path_ = paths_.empty() || paths_[0].selected_ ? -1 : 0;
 
   bool successful = readValue();
   Token token;
   skipCommentTokens(token);
-  if (collectComments_ && !commentsBefore_.empty())
-    root.setComment(commentsBefore_, commentAfter);
   if (features_.strictRoot_) {
-    if (!root.isArray() && !root.isObject()) {
+    if (!rootIsContainer_) {
       // Set error location to start of doc, ideally should be first token found
       // in doc
       token.type_ = tokenError;
@@ -137,82 +447,61 @@ bool Reader::parse(const char* beginDoc,
   return successful;
 }
 
-bool Reader::readValue() {
+bool SaxReader::readValue() {
   Token token;
   skipCommentTokens(token);
   bool successful = true;
 
-  if (collectComments_ && !commentsBefore_.empty()) {
-    currentValue().setComment(commentsBefore_, commentBefore);
-    commentsBefore_ = "";
-  }
-
   switch (token.type_) {
   case tokenObjectBegin:
     successful = readObject(token);
-    currentValue().setOffsetLimit(current_ - begin_);
     break;
   case tokenArrayBegin:
     successful = readArray(token);
-    currentValue().setOffsetLimit(current_ - begin_);
     break;
   case tokenNumber:
     successful = decodeNumber(token);
     break;
-  case tokenString:
-    successful = decodeString(token);
-    break;
-  case tokenTrue:
-    {
-    Value v(true);
-    currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
+  case tokenString: {
+    Location begin, end;
+    successful = decodeString(token, begin, end);
+    if (successful) {
+      setValueRange(token.start_, token.end_);
+      handler_->onString(begin, end);
     }
+  } break;
+  case tokenTrue:
+    setValueRange(token.start_, token.end_);
+    handler_->onBool(true);
     break;
   case tokenFalse:
-    {
-    Value v(false);
-    currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
-    }
+    setValueRange(token.start_, token.end_);
+    handler_->onBool(false);
     break;
   case tokenNull:
-    {
-    Value v;
-    currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
-    }
+    setValueRange(token.start_, token.end_);
+    handler_->onNull();
     break;
   case tokenArraySeparator:
     if (features_.allowDroppedNullPlaceholders_) {
-      // "Un-read" the current token and mark the current value as a null
-      // token.
+      // "Un-read" the current token and report a null value.
       current_--;
-      Value v;
-      currentValue().swapPayload(v);
-      currentValue().setOffsetStart(current_ - begin_ - 1);
-      currentValue().setOffsetLimit(current_ - begin_);
+      setValueRange(current_ - 1, current_);
+      handler_->onNull();
       break;
     }
   // Else, fall through...
   default:
-    currentValue().setOffsetStart(token.start_ - begin_);
-    currentValue().setOffsetLimit(token.end_ - begin_);
     return addError("Syntax error: value, object or array expected.", token);
   }
 
-  if (collectComments_) {
+  if (collectComments_)
     lastValueEnd_ = current_;
-    lastValue_ = &currentValue();
-  }
 
   return successful;
 }
 
-void Reader::skipCommentTokens(Token& token) {
+void SaxReader::skipCommentTokens(Token& token) {
   if (features_.allowComments_) {
     do {
       readToken(token);
@@ -222,7 +511,7 @@ void Reader::skipCommentTokens(Token& token) {
   }
 }
 
-bool Reader::readToken(Token& token) {
+bool SaxReader::readToken(Token& token) {
   skipSpaces();
   token.start_ = current_;
   Char c = getNextChar();
@@ -260,7 +549,7 @@ bool Reader::readToken(Token& token) {
   case '9':
   case '-':
     token.type_ = tokenNumber;
-    readNumber();
+    token.isReal_ = readNumber();
     break;
   case 't':
     token.type_ = tokenTrue;
@@ -293,17 +582,24 @@ bool Reader::readToken(Token& token) {
   return true;
 }
 
-void Reader::skipSpaces() {
-  while (current_ != end_) {
-    Char c = *current_;
-    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
-      ++current_;
-    else
-      break;
+void SaxReader::skipSpaces() { current_ = scanSpaces(current_, end_); }
+
+void SaxReader::skipSpacesAndComments() {
+  skipSpaces();
+  while (features_.allowComments_ && current_ != end_ && *current_ == '/') {
+    // Comments before a skipped value are not reported.
+    int path = path_;
+    path_ = 0;
+    ++current_;
+    bool ok = readComment();
+    path_ = path;
+    if (!ok)
+      return; // the next token reports the error
+    skipSpaces();
   }
 }
 
-bool Reader::match(Location pattern, int patternLength) {
+bool SaxReader::match(Location pattern, int patternLength) {
   if (end_ - current_ < patternLength)
     return false;
   int index = patternLength;
@@ -314,7 +610,7 @@ bool Reader::match(Location pattern, int patternLength) {
   return true;
 }
 
-bool Reader::readComment() {
+bool SaxReader::readComment() {
   Location commentBegin = current_ - 1;
   Char c = getNextChar();
   bool successful = false;
@@ -325,59 +621,28 @@ bool Reader::readComment() {
   if (!successful)
     return false;
 
-  if (collectComments_) {
+  if (collectComments_ && path_ < 0) {
     CommentPlacement placement = commentBefore;
     if (lastValueEnd_ && !containsNewLine(lastValueEnd_, commentBegin)) {
       if (c != '*' || !containsNewLine(commentBegin, current_))
         placement = commentAfterOnSameLine;
     }
 
-    addComment(commentBegin, current_, placement);
+    handler_->onComment(commentBegin, current_, placement);
   }
   return true;
 }
 
-static std::string normalizeEOL(Reader::Location begin, Reader::Location end) {
-  std::string normalized;
-  normalized.reserve(end - begin);
-  Reader::Location current = begin;
-  while (current != end) {
-    char c = *current++;
-    if (c == '\r') {
-      if (current != end && *current == '\n')
-         // convert dos EOL
-         ++current;
-      // convert Mac EOL
-      normalized += '\n';
-    } else {
-      normalized += c;
-    }
-  }
-  return normalized;
-}
-
-void
-Reader::addComment(Location begin, Location end, CommentPlacement placement) {
-  assert(collectComments_);
-  const std::string& normalized = normalizeEOL(begin, end);
-  if (placement == commentAfterOnSameLine) {
-    assert(lastValue_ != 0);
-    lastValue_->setComment(normalized, placement);
-  } else {
-    commentsBefore_ += normalized;
-  }
-}
-
-bool Reader::readCStyleComment() {
+bool SaxReader::readCStyleComment() {
   while (current_ != end_) {
     Char c = getNextChar();
-    if (c == '*' && *current_ == '/')
+    if (c == '*' && current_ != end_ && *current_ == '/')
       break;
   }
   return getNextChar() == '/';
 }
 
-bool Reader::readCppStyleComment() {
+bool SaxReader::readCppStyleComment() {
   while (current_ != end_) {
     Char c = getNextChar();
     if (c == '\n')
@@ -393,76 +658,92 @@ bool Reader::readCppStyleComment() {
   return true;
 }
 
-void Reader::readNumber() {
-  const char *p = current_;
-  char c = '0'; // stopgap for already consumed character
-  // integral part
-  while (c >= '0' && c <= '9')
-    c = (current_ = p) < end_ ? *p++ : 0;
+bool SaxReader::readNumber() {
+  // integral part (the first character was already consumed)
+  current_ = scanDigits(current_, end_);
+  bool isReal = false;
   // fractional part
-  if (c == '.') {
-    c = (current_ = p) < end_ ? *p++ : 0;
-    while (c >= '0' && c <= '9')
-      c = (current_ = p) < end_ ? *p++ : 0;
+  if (current_ != end_ && *current_ == '.') {
+    isReal = true;
+    current_ = scanDigits(current_ + 1, end_);
   }
   // exponential part
-  if (c == 'e' || c == 'E') {
-    c = (current_ = p) < end_ ? *p++ : 0;
-    if (c == '+' || c == '-')
-      c = (current_ = p) < end_ ? *p++ : 0;
-    while (c >= '0' && c <= '9')
-      c = (current_ = p) < end_ ? *p++ : 0;
+  if (current_ != end_ && (*current_ == 'e' || *current_ == 'E')) {
+    isReal = true;
+    ++current_;
+    if (current_ != end_ && (*current_ == '+' || *current_ == '-'))
+      ++current_;
+    current_ = scanDigits(current_, end_);
   }
+  return isReal;
 }
 
-bool Reader::readString() {
-  Char c = 0;
-  while (current_ != end_) {
-    c = getNextChar();
-    if (c == '\\')
-      getNextChar();
-    else if (c == '"')
-      break;
+bool SaxReader::readString() {
+  for (;;) {
+    current_ = scanStringSpecial(current_, end_);
+    if (current_ == end_)
+      return false;
+    if (*current_++ == '"')
+      return true;
+    // Skip the escaped character; it is checked by decodeString().
+    if (current_ == end_)
+      return false;
+    ++current_;
   }
-  return c == '"';
 }
 
-bool Reader::readObject(Token& tokenStart) {
+bool SaxReader::readObject(Token& tokenStart) {
+  // Containers can only be nested in a container, so any object or array
+  // means the root is one.
+  rootIsContainer_ = true;
+  setValueRange(tokenStart.start_, tokenStart.end_);
+  handler_->onObjectBegin();
+  bool successful = readObjectMembers();
+  // Always balance onObjectBegin(), even if parsing failed.
+  setValueRange(tokenStart.start_, current_);
+  handler_->onObjectEnd();
+  return successful;
+}
+
+bool SaxReader::readObjectMembers() {
   Token tokenName;
-  std::string name;
-  Value init(objectValue);
-  currentValue().swapPayload(init);
-  currentValue().setOffsetStart(tokenStart.start_ - begin_);
+  bool nameIsEmpty = true;
   while (readToken(tokenName)) {
     bool initialTokenOk = true;
     while (tokenName.type_ == tokenComment && initialTokenOk)
       initialTokenOk = readToken(tokenName);
     if (!initialTokenOk)
       break;
-    if (tokenName.type_ == tokenObjectEnd && name.empty()) // empty object
+    if (tokenName.type_ == tokenObjectEnd && nameIsEmpty) // empty object
       return true;
-    name = "";
+    Location nameBegin, nameEnd;
     if (tokenName.type_ == tokenString) {
-      if (!decodeString(tokenName, name))
+      if (!decodeString(tokenName, nameBegin, nameEnd))
         return recoverFromError(tokenObjectEnd);
     } else if (tokenName.type_ == tokenNumber && features_.allowNumericKeys_) {
       Value numberName;
       if (!decodeNumber(tokenName, numberName))
         return recoverFromError(tokenObjectEnd);
-      name = numberName.asString();
+      decoded_ = numberName.asString();
+      nameBegin = decoded_.data();
+      nameEnd = nameBegin + decoded_.length();
     } else {
       break;
     }
+    nameIsEmpty = nameBegin == nameEnd;
 
     Token colon;
     if (!readToken(colon) || colon.type_ != tokenMemberSeparator) {
       return addErrorAndRecover(
           "Missing ':' after object member name", colon, tokenObjectEnd);
     }
-    Value& value = currentValue()[name];
-    nodes_.push(&value);
-    bool ok = readValue();
-    nodes_.pop();
+    bool ok;
+    if (path_ < 0) {
+      handler_->onKey(nameBegin, nameEnd);
+      ok = readValue();
+    } else {
+      ok = readPathMember(path_, nameBegin, nameEnd);
+    }
     if (!ok) // error already set
       return recoverFromError(tokenObjectEnd);
 
@@ -483,23 +764,27 @@ bool Reader::readObject(Token& tokenStart) {
       "Missing '}' or object member name", tokenName, tokenObjectEnd);
 }
 
-bool Reader::readArray(Token& tokenStart) {
-  Value init(arrayValue);
-  currentValue().swapPayload(init);
-  currentValue().setOffsetStart(tokenStart.start_ - begin_);
+bool SaxReader::readArray(Token& tokenStart) {
+  rootIsContainer_ = true;
+  setValueRange(tokenStart.start_, tokenStart.end_);
+  handler_->onArrayBegin();
+  bool successful = readArrayElements();
+  // Always balance onArrayBegin(), even if parsing failed.
+  setValueRange(tokenStart.start_, current_);
+  handler_->onArrayEnd();
+  return successful;
+}
+
+bool SaxReader::readArrayElements() {
   skipSpaces();
-  if (*current_ == ']') // empty array
+  if (current_ != end_ && *current_ == ']') // empty array
   {
     Token endArray;
     readToken(endArray);
     return true;
   }
-  int index = 0;
-  for (;;) {
-    Value& value = currentValue()[index++];
-    nodes_.push(&value);
-    bool ok = readValue();
-    nodes_.pop();
+  for (ArrayIndex index = 0;; ++index) {
+    bool ok = path_ < 0 ? readValue() : readPathElement(path_, index);
     if (!ok) // error already set
       return recoverFromError(tokenArrayEnd);
 
@@ -521,68 +806,230 @@ bool Reader::readArray(Token& tokenStart) {
   return true;
 }
 
-bool Reader::decodeNumber(Token& token) {
-  Value decoded;
-  if (!decodeNumber(token, decoded))
-    return false;
-  currentValue().swapPayload(decoded);
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
-  return true;
+// Partial parsing
+// //////////////////////////////////////////////////////////////////
+
+int SaxReader::findPath(int parent, Location keyBegin, Location keyEnd) const {
+  const std::vector<int>& children = paths_[parent].children_;
+  size_t length = size_t(keyEnd - keyBegin);
+  for (size_t index = 0; index < children.size(); ++index) {
+    const std::string& key = paths_[children[index]].key_;
+    if (key.size() == length && memcmp(key.data(), keyBegin, length) == 0)
+      return children[index];
+  }
+  return -1;
 }
 
-bool Reader::decodeNumber(Token& token, Value& decoded) {
-  // Attempts to parse the number as an integer. If the number is
-  // larger than the maximum supported value of an integer then
-  // we decode the number as a double.
-  Location current = token.start_;
-  bool isNegative = *current == '-';
-  if (isNegative)
-    ++current;
-  // TODO: Help the compiler do the div and mod at compile time or get rid of them.
-  Value::LargestUInt maxIntegerValue =
-      isNegative ? Value::LargestUInt(-Value::minLargestInt)
-                 : Value::maxLargestUInt;
-  Value::LargestUInt threshold = maxIntegerValue / 10;
-  Value::LargestUInt value = 0;
-  while (current < token.end_) {
-    Char c = *current++;
-    if (c < '0' || c > '9')
-      return decodeDouble(token, decoded);
-    Value::UInt digit(c - '0');
-    if (value >= threshold) {
-      // We've hit or exceeded the max value divided by 10 (rounded down). If
-      // a) we've only just touched the limit, b) this is the last digit, and
-      // c) it's small enough to fit in that rounding delta, we're okay.
-      // Otherwise treat this number as a double to avoid overflow.
-      if (value > threshold || current != token.end_ ||
-          digit > maxIntegerValue % 10) {
-        return decodeDouble(token, decoded);
+int SaxReader::findPath(int parent, ArrayIndex index) const {
+  const std::vector<int>& children = paths_[parent].children_;
+  for (size_t i = 0; i < children.size(); ++i) {
+    if (paths_[children[i]].index_ == index)
+      return children[i];
+  }
+  return -1;
+}
+
+bool SaxReader::nextIsContainer() {
+  skipSpacesAndComments();
+  return current_ != end_ && (*current_ == '{' || *current_ == '[');
+}
+
+bool SaxReader::readPathMember(int path, Location nameBegin, Location nameEnd) {
+  int child = findPath(path, nameBegin, nameEnd);
+  // A path going through a scalar does not select anything.
+  if (child < 0 || (!paths_[child].selected_ && !nextIsContainer()))
+    return skipValue();
+  path_ = paths_[child].selected_ ? -1 : child;
+  handler_->onKey(nameBegin, nameEnd);
+  bool ok = readValue();
+  path_ = path;
+  return ok;
+}
+
+bool SaxReader::readPathElement(int path, ArrayIndex index) {
+  const PathNode& node = paths_[path];
+  int child = index < node.indexLimit_ ? findPath(path, index) : -1;
+  if (child < 0 || (!paths_[child].selected_ && !nextIsContainer())) {
+    skipSpacesAndComments();
+    Location start = current_;
+    if (!skipValue())
+      return false;
+    if (index < node.indexLimit_) {
+      // Keep the index of the selected elements that follow.
+      setValueRange(start, current_);
+      handler_->onNull();
+    }
+    return true;
+  }
+  path_ = paths_[child].selected_ ? -1 : child;
+  bool ok = readValue();
+  path_ = path;
+  return ok;
+}
+
+bool SaxReader::skipValue() {
+  skipSpacesAndComments();
+  if (current_ != end_ && (*current_ == '{' || *current_ == '['))
+    return skipContainer();
+  Token token;
+  readToken(token);
+  switch (token.type_) {
+  case tokenString:
+  case tokenNumber:
+  case tokenTrue:
+  case tokenFalse:
+  case tokenNull:
+    return true;
+  case tokenArraySeparator:
+    if (features_.allowDroppedNullPlaceholders_) {
+      // "Un-read" the current token, like readValue().
+      current_--;
+      return true;
+    }
+  // Else, fall through...
+  default:
+    return addError("Syntax error: value, object or array expected.", token);
+  }
+}
+
+/* Skips an object or an array by matching brackets: only strings and
+ * comments need to be read, since they may contain brackets. Everything else
+ * is left unchecked.
+ */
+bool SaxReader::skipContainer() {
+  Token token;
+  token.type_ = tokenError;
+  token.start_ = current_;
+  int path = path_;
+  path_ = 0; // do not report comments
+  size_t depth = 0;
+  bool ok = true;
+  for (;;) {
+    current_ = scanStructural(current_, end_);
+    if (current_ == end_) {
+      token.end_ = current_;
+      ok = addError("Missing closing bracket of skipped value", token);
+      break;
+    }
+    Char c = *current_++;
+    if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (--depth == 0)
+        break;
+    } else if (c == '"') {
+      if (!readString()) {
+        token.end_ = current_;
+        ok = addError("Missing '\"' at end of skipped string", token);
+        break;
       }
+    } else if (!features_.allowComments_ || !readComment()) {
+      token.end_ = current_;
+      ok = addError("Syntax error in skipped value", token);
+      break;
     }
-    value = value * 10 + digit;
   }
-  if (isNegative)
-    decoded = -Value::LargestInt(value);
-  else if (value <= Value::LargestUInt(Value::maxInt))
-    decoded = Value::LargestInt(value);
-  else
-    decoded = value;
+  path_ = path;
+  return ok;
+}
+
+void SaxReader::setValueRange(Location start, Location limit) {
+  valueStart_ = start - begin_;
+  valueLimit_ = limit - begin_;
+}
+
+// Digits of the largest magnitudes decodeInteger() accepts.
+#if defined(JSON_HAS_INT64)
+static const char largestUIntDigits[] = "18446744073709551615";
+static const char largestNegativeDigits[] = "9223372036854775808";
+#else  // if defined(JSON_HAS_INT64)
+static const char largestUIntDigits[] = "4294967295";
+static const char largestNegativeDigits[] = "2147483648";
+#endif // if defined(JSON_HAS_INT64)
+
+/// Returns \c true if the digits in [begin, end), without leading zeros, are
+/// no greater than \a limit. Comparing the text avoids a per-digit overflow
+/// check.
+static bool digitsFitIn(const char* begin, const char* end, const char* limit) {
+  size_t length = size_t(end - begin);
+  size_t limitLength = strlen(limit);
+  if (length != limitLength)
+    return length < limitLength;
+  return memcmp(begin, limit, length) <= 0;
+}
+
+bool SaxReader::decodeNumber(Token& token) {
+  bool isNegative;
+  LargestUInt magnitude;
+  if (decodeInteger(token, isNegative, magnitude)) {
+    setValueRange(token.start_, token.end_);
+    if (!isNegative)
+      handler_->onUInt(magnitude);
+    else if (magnitude == LargestUInt(Value::maxLargestInt) + 1)
+      handler_->onInt(Value::minLargestInt);
+    else
+      handler_->onInt(-LargestInt(magnitude));
+    return true;
+  }
+  double value;
+  if (!decodeDouble(token, value))
+    return false;
+  setValueRange(token.start_, token.end_);
+  handler_->onDouble(value);
   return true;
 }
 
-bool Reader::decodeDouble(Token& token) {
-  Value decoded;
-  if (!decodeDouble(token, decoded))
+bool SaxReader::decodeNumber(Token& token, Value& decoded) {
+  bool isNegative;
+  LargestUInt magnitude;
+  if (decodeInteger(token, isNegative, magnitude)) {
+    if (!isNegative && magnitude > LargestUInt(Value::maxInt))
+      decoded = magnitude;
+    else if (isNegative && magnitude == LargestUInt(Value::maxLargestInt) + 1)
+      decoded = Value::minLargestInt;
+    else
+      decoded = isNegative ? -LargestInt(magnitude) : LargestInt(magnitude);
+    return true;
+  }
+  double value;
+  if (!decodeDouble(token, value))
     return false;
-  currentValue().swapPayload(decoded);
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
+  decoded = value;
   return true;
 }
 
-bool Reader::decodeDouble(Token& token, Value& decoded) {
+bool SaxReader::decodeInteger(Token& token,
+                              bool& isNegative,
+                              LargestUInt& magnitude) {
+  // readNumber() already told reals from integers, so the token only holds
+  // an optional '-' and digits here.
+  if (token.isReal_)
+    return false;
+  Location current = token.start_;
+  isNegative = *current == '-';
+  if (isNegative)
+    ++current;
+  // Leading zeros do not change the value.
+  while (current != token.end_ && *current == '0')
+    ++current;
+  // If the number is larger than the maximum supported value of an integer
+  // then it will be decoded as a double.
+  const char* limit = isNegative ? largestNegativeDigits : largestUIntDigits;
+  if (!digitsFitIn(current, token.end_, limit))
+    return false;
+  magnitude = decimalDigitsToUInt(current, token.end_);
+  return true;
+}
+
+bool SaxReader::decodeDouble(Token& token, double& decoded) {
   double value = 0;
+#if defined(JSON_HAS_INT64)
+  // Parses the token in place, independently of the C locale.
+  if (!parseDouble(token.start_, token.end_, value))
+    return addError("'" + std::string(token.start_, token.end_) +
+                        "' is not a number.",
+                    token);
+#else  // if defined(JSON_HAS_INT64)
   const int bufferSize = 32;
   int count;
   int length = int(token.end_ - token.start_);
@@ -613,75 +1060,96 @@ bool Reader::decodeDouble(Token& token, Value& decoded) {
     return addError("'" + std::string(token.start_, token.end_) +
                         "' is not a number.",
                     token);
+#endif // if defined(JSON_HAS_INT64)
   decoded = value;
   return true;
 }
 
-bool Reader::decodeString(Token& token) {
-  std::string decoded_string;
-  if (!decodeString(token, decoded_string))
+// Character an escape sequence stands for, indexed by the character that
+// follows the backslash: 0 if the escape sequence is invalid, 'u' for \uXXXX.
+static const char escapedCharacters[128] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '/',
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+    0, 0, '\b', 0, 0, 0, '\f', 0, 0, 0, 0, 0, 0, 0, '\n', 0,
+    0, 0, '\r', 0, '\t', 'u', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// Value of a hexadecimal digit, 0xFF for other characters.
+static const unsigned char hexDigitValues[128] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0,    1,    2,    3,    4,    5,    6,    7,
+    8,    9,    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 10,   11,   12,   13,   14,   15,   0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 10,   11,   12,   13,   14,   15,   0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static inline unsigned int hexDigitValue(char c) {
+  unsigned char byte = static_cast<unsigned char>(c);
+  return byte < 128 ? hexDigitValues[byte] : 0xFF;
+}
+
+bool SaxReader::decodeString(Token& token, Location& begin, Location& end) {
+  begin = token.start_ + 1; // skip '"'
+  end = token.end_ - 1;     // do not include '"'
+  // Escape sequences are ASCII, so checking the text as written is enough.
+  if (features_.validateUTF8_) {
+    Location invalid = validateUTF8(begin, end);
+    if (invalid != end)
+      return addError("Invalid UTF-8 sequence in string", token, invalid);
+  }
+  // Without escape sequences the text can be handed out as is.
+  if (memchr(begin, '\\', end - begin) == 0)
+    return true;
+  decoded_.clear();
+  if (!decodeString(token, decoded_))
     return false;
-  Value decoded(decoded_string);
-  currentValue().swapPayload(decoded);
-  currentValue().setOffsetStart(token.start_ - begin_);
-  currentValue().setOffsetLimit(token.end_ - begin_);
+  begin = decoded_.data();
+  end = begin + decoded_.length();
   return true;
 }
 
-bool Reader::decodeString(Token& token, std::string& decoded) {
+bool SaxReader::decodeString(Token& token, std::string& decoded) {
   decoded.reserve(token.end_ - token.start_ - 2);
   Location current = token.start_ + 1; // skip '"'
   Location end = token.end_ - 1;       // do not include '"'
-  while (current != end) {
-    Char c = *current++;
-    if (c == '"')
-      break;
-    else if (c == '\\') {
-      if (current == end)
-        return addError("Empty escape sequence in string", token, current);
-      Char escape = *current++;
-      switch (escape) {
-      case '"':
-        decoded += '"';
-        break;
-      case '/':
-        decoded += '/';
-        break;
-      case '\\':
-        decoded += '\\';
-        break;
-      case 'b':
-        decoded += '\b';
-        break;
-      case 'f':
-        decoded += '\f';
-        break;
-      case 'n':
-        decoded += '\n';
-        break;
-      case 'r':
-        decoded += '\r';
-        break;
-      case 't':
-        decoded += '\t';
-        break;
-      case 'u': {
-        unsigned int unicode;
-        if (!decodeUnicodeCodePoint(token, current, end, unicode))
-          return false;
-        decoded += codePointToUTF8(unicode);
-      } break;
-      default:
-        return addError("Bad escape sequence in string", token, current);
-      }
-    } else {
+  for (;;) {
+    // Copy the run up to the next escape sequence at once.
+    Location special = scanStringSpecial(current, end);
+    decoded.append(current, special);
+    if (special == end || *special == '"')
+      return true;
+    current = special + 1;
+    if (current == end)
+      return addError("Empty escape sequence in string", token, current);
+    unsigned char escape = static_cast<unsigned char>(*current++);
+    char c = escape < 128 ? escapedCharacters[escape] : 0;
+    if (c == 0)
+      return addError("Bad escape sequence in string", token, current);
+    if (c != 'u') {
       decoded += c;
+      continue;
     }
+    unsigned int unicode;
+    if (!decodeUnicodeCodePoint(token, current, end, unicode))
+      return false;
+    appendUTF8(unicode, decoded);
   }
-  return true;
 }
 
-bool Reader::decodeUnicodeCodePoint(Token& token,
+bool SaxReader::decodeUnicodeCodePoint(Token& token,
                                     Location& current,
                                     Location end,
                                     unsigned int& unicode) {
@@ -698,6 +1166,11 @@ bool Reader::decodeUnicodeCodePoint(Token& token,
     unsigned int surrogatePair;
     if (*(current++) == '\\' && *(current++) == 'u') {
       if (decodeUnicodeEscapeSequence(token, current, end, surrogatePair)) {
+        if (features_.validateUTF8_ &&
+            (surrogatePair < 0xDC00 || surrogatePair > 0xDFFF))
+          return addError("Bad second half of a unicode surrogate pair",
+                          token,
+                          current);
         unicode = 0x10000 + ((unicode & 0x3FF) << 10) + (surrogatePair & 0x3FF);
       } else
         return false;
@@ -706,11 +1179,17 @@ bool Reader::decodeUnicodeCodePoint(Token& token,
                       "a unicode surrogate pair",
                       token,
                       current);
+  } else if (features_.validateUTF8_ && unicode >= 0xDC00 &&
+             unicode <= 0xDFFF) {
+    return addError(
+        "Second half of a unicode surrogate pair without a first half",
+        token,
+        current);
   }
   return true;
 }
 
-bool Reader::decodeUnicodeEscapeSequence(Token& token,
+bool SaxReader::decodeUnicodeEscapeSequence(Token& token,
                                          Location& current,
                                          Location end,
                                          unsigned int& unicode) {
@@ -719,27 +1198,29 @@ bool Reader::decodeUnicodeEscapeSequence(Token& token,
         "Bad unicode escape sequence in string: four digits expected.",
         token,
         current);
-  unicode = 0;
+  unsigned int digits[4];
+  unsigned int invalid = 0;
   for (int index = 0; index < 4; ++index) {
-    Char c = *current++;
-    unicode *= 16;
-    if (c >= '0' && c <= '9')
-      unicode += c - '0';
-    else if (c >= 'a' && c <= 'f')
-      unicode += c - 'a' + 10;
-    else if (c >= 'A' && c <= 'F')
-      unicode += c - 'A' + 10;
-    else
-      return addError(
-          "Bad unicode escape sequence in string: hexadecimal digit expected.",
-          token,
-          current);
+    digits[index] = hexDigitValue(current[index]);
+    invalid |= digits[index];
+  }
+  if (invalid > 0xF) {
+    int index = 0;
+    while (digits[index] <= 0xF)
+      ++index;
+    current += index + 1;
+    return addError(
+        "Bad unicode escape sequence in string: hexadecimal digit expected.",
+        token,
+        current);
   }
+  unicode = (digits[0] << 12) | (digits[1] << 8) | (digits[2] << 4) | digits[3];
+  current += 4;
   return true;
 }
 
 bool
-Reader::addError(const std::string& message, Token& token, Location extra) {
+SaxReader::addError(const std::string& message, Token& token, Location extra) {
   ErrorInfo info;
   info.token_ = token;
   info.message_ = message;
@@ -748,7 +1229,7 @@ Reader::addError(const std::string& message, Token& token, Location extra) {
   return false;
 }
 
-bool Reader::recoverFromError(TokenType skipUntilToken) {
+bool SaxReader::recoverFromError(TokenType skipUntilToken) {
   int errorCount = int(errors_.size());
   Token skip;
   for (;;) {
@@ -761,22 +1242,20 @@ bool Reader::recoverFromError(TokenType skipUntilToken) {
   return false;
 }
 
-bool Reader::addErrorAndRecover(const std::string& message,
+bool SaxReader::addErrorAndRecover(const std::string& message,
                                 Token& token,
                                 TokenType skipUntilToken) {
   addError(message, token);
   return recoverFromError(skipUntilToken);
 }
 
-Value& Reader::currentValue() { return *(nodes_.top()); }
-
-Reader::Char Reader::getNextChar() {
+SaxReader::Char SaxReader::getNextChar() {
   if (current_ == end_)
     return 0;
   return *current_++;
 }
 
-void Reader::getLocationLineAndColumn(Location location,
+void SaxReader::getLocationLineAndColumn(Location location,
                                       int& line,
                                       int& column) const {
   Location current = begin_;
@@ -785,7 +1264,7 @@ void Reader::getLocationLineAndColumn(Location location,
   while (current < location && current != end_) {
     Char c = *current++;
     if (c == '\r') {
-      if (*current == '\n')
+      if (current != end_ && *current == '\n')
         ++current;
       lastLineStart = current;
       ++line;
@@ -799,7 +1278,7 @@ void Reader::getLocationLineAndColumn(Location location,
   ++line;
 }
 
-std::string Reader::getLocationLineAndColumn(Location location) const {
+std::string SaxReader::getLocationLineAndColumn(Location location) const {
   int line, column;
   getLocationLineAndColumn(location, line, column);
   char buffer[18 + 16 + 16 + 1];
@@ -815,12 +1294,7 @@ std::string Reader::getLocationLineAndColumn(Location location) const {
   return buffer;
 }
 
-// Deprecated. Preserved for backward compatibility
-std::string Reader::getFormatedErrorMessages() const {
-  return getFormattedErrorMessages();
-}
-
-std::string Reader::getFormattedErrorMessages() const {
+std::string SaxReader::getFormattedErrorMessages() const {
   std::string formattedMessage;
   for (Errors::const_iterator itError = errors_.begin();
        itError != errors_.end();
@@ -836,13 +1310,13 @@ std::string Reader::getFormattedErrorMessages() const {
   return formattedMessage;
 }
 
-std::vector<Reader::StructuredError> Reader::getStructuredErrors() const {
-  std::vector<Reader::StructuredError> allErrors;
+std::vector<SaxReader::StructuredError> SaxReader::getStructuredErrors() const {
+  std::vector<SaxReader::StructuredError> allErrors;
   for (Errors::const_iterator itError = errors_.begin();
        itError != errors_.end();
        ++itError) {
     const ErrorInfo& error = *itError;
-    Reader::StructuredError structured;
+    StructuredError structured;
     structured.offset_start = error.token_.start_ - begin_;
     structured.offset_limit = error.token_.end_ - begin_;
     structured.message = error.message_;
@@ -851,7 +1325,7 @@ std::vector<Reader::StructuredError> Reader::getStructuredErrors() const {
   return allErrors;
 }
 
-bool Reader::pushError(const Value& value, const std::string& message) {
+bool SaxReader::pushError(const Value& value, const std::string& message) {
   size_t length = end_ - begin_;
   if(value.getOffsetStart() > length
     || value.getOffsetLimit() > length)
@@ -859,7 +1333,7 @@ bool Reader::pushError(const Value& value, const std::string& message) {
   Token token;
   token.type_ = tokenError;
   token.start_ = begin_ + value.getOffsetStart();
-  token.end_ = end_ + value.getOffsetLimit();
+  token.end_ = begin_ + value.getOffsetLimit();
   ErrorInfo info;
   info.token_ = token;
   info.message_ = message;
@@ -868,7 +1342,7 @@ bool Reader::pushError(const Value& value, const std::string& message) {
   return true;
 }
 
-bool Reader::pushError(const Value& value, const std::string& message, const Value& extra) {
+bool SaxReader::pushError(const Value& value, const std::string& message, const Value& extra) {
   size_t length = end_ - begin_;
   if(value.getOffsetStart() > length
     || value.getOffsetLimit() > length
@@ -886,10 +1360,435 @@ bool Reader::pushError(const Value& value, const std::string& message, const Val
   return true;
 }
 
-bool Reader::good() const {
+bool SaxReader::good() const {
   return !errors_.size();
 }
 
+static std::string normalizeEOL(const char* begin, const char* end) {
+  std::string normalized;
+  normalized.reserve(end - begin);
+  const char* current = begin;
+  while (current != end) {
+    char c = *current++;
+    if (c == '\r') {
+      if (current != end && *current == '\n')
+         // convert dos EOL
+         ++current;
+      // convert Mac EOL
+      normalized += '\n';
+    } else {
+      normalized += c;
+    }
+  }
+  return normalized;
+}
+
+size_t SaxReader::getOffsetStart() const { return valueStart_; }
+
+size_t SaxReader::getOffsetLimit() const { return valueLimit_; }
+
+const char* SaxReader::getDocumentBegin() const { return begin_; }
+
+const char* SaxReader::getDocumentEnd() const { return end_; }
+
+// Implementation of class Reader
+// ////////////////////////////////
+
+Reader::Reader()
+    : sax_(), nodes_(), member_(), lastValue_(), lastParent_(), lastStart_(),
+      lastMoved_(), storeOffsets_(), commentsBefore_(),
+      resource_(), keyTable_() {}
+
+Reader::Reader(const Features& features)
+    : sax_(features), nodes_(), member_(), lastValue_(), lastParent_(),
+      lastStart_(), lastMoved_(), storeOffsets_(), commentsBefore_(),
+      resource_(), keyTable_() {}
+
+void Reader::setArena(ValueArena* arena) { resource_ = arena; }
+
+void Reader::setMemoryResource(MemoryResource* resource) {
+  resource_ = resource;
+}
+
+void Reader::setKeyTable(KeyTable* keyTable) { keyTable_ = keyTable; }
+
+bool Reader::addPath(const std::string& pointer) {
+  return sax_.addPath(pointer);
+}
+
+void Reader::clearPaths() { sax_.clearPaths(); }
+
+bool
+Reader::parse(const std::string& document, Value& root, bool collectComments) {
+  startDocument(root, collectComments);
+  return endDocument(root, sax_.parse(document, *this, collectComments));
+}
+
+bool Reader::parse(std::istream& sin, Value& root, bool collectComments) {
+  startDocument(root, collectComments);
+  return endDocument(root, sax_.parse(sin, *this, collectComments));
+}
+
+bool
+Reader::parseFile(const std::string& path, Value& root, bool collectComments) {
+  startDocument(root, collectComments);
+  return endDocument(root, sax_.parseFile(path, *this, collectComments));
+}
+
+#if defined(_WIN32)
+bool
+Reader::parseFile(const std::wstring& path, Value& root, bool collectComments) {
+  startDocument(root, collectComments);
+  return endDocument(root, sax_.parseFile(path, *this, collectComments));
+}
+#endif
+
+bool Reader::parse(const char* beginDoc,
+                   const char* endDoc,
+                   Value& root,
+                   bool collectComments) {
+  startDocument(root, collectComments);
+  return endDocument(
+      root, sax_.parse(beginDoc, endDoc, *this, collectComments));
+}
+
+/// Adds \a delta to the offsets of \a value and all its descendants.
+static void shiftOffsets(Value& value, size_t delta) {
+  value.setOffsetStart(value.getOffsetStart() + delta);
+  value.setOffsetLimit(value.getOffsetLimit() + delta);
+  if (value.isArray() || value.isObject()) {
+    for (Value::iterator it = value.begin(); it != value.end(); ++it)
+      shiftOffsets(*it, delta);
+  }
+}
+
+/* Moves the offsets at or past \a limit, the end of the value \a skipped
+ * being replaced, by \a delta (modulo arithmetic handles shrinking). Values
+ * that end before the replaced one are left alone with all their
+ * descendants.
+ */
+static void moveOffsetsAfter(Value& value,
+                             const Value& skipped,
+                             size_t limit,
+                             size_t delta) {
+  if (&value == &skipped || value.getOffsetLimit() < limit)
+    return;
+  if (value.getOffsetStart() >= limit)
+    value.setOffsetStart(value.getOffsetStart() + delta);
+  value.setOffsetLimit(value.getOffsetLimit() + delta);
+  if (value.isArray() || value.isObject()) {
+    for (Value::iterator it = value.begin(); it != value.end(); ++it)
+      moveOffsetsAfter(*it, skipped, limit, delta);
+  }
+}
+
+bool Reader::reparse(const std::string& oldDocument,
+                     Value& root,
+                     const std::string& newDocument,
+                     bool collectComments) {
+  const char* oldBegin = oldDocument.data();
+  const char* newBegin = newDocument.data();
+  return reparse(oldBegin,
+                 oldBegin + oldDocument.size(),
+                 root,
+                 newBegin,
+                 newBegin + newDocument.size(),
+                 collectComments);
+}
+
+bool Reader::reparse(const char* oldBeginDoc,
+                     const char* oldEndDoc,
+                     Value& root,
+                     const char* newBeginDoc,
+                     const char* newEndDoc,
+                     bool collectComments) {
+  // Without offsets, as when built with JSON_COMPACT_VALUE and comments
+  // were not collected, no part of the tree can be kept.
+  if (sax_.hasPaths() || root.getOffsetLimit() == 0)
+    return parseAgain(newBeginDoc, newEndDoc, root, collectComments);
+
+  // The edit replaced [changeBegin, oldChangeEnd) of the old document, the
+  // bytes before and after it are shared by both documents.
+  size_t oldSize = size_t(oldEndDoc - oldBeginDoc);
+  size_t newSize = size_t(newEndDoc - newBeginDoc);
+  size_t changeBegin =
+      size_t(std::mismatch(oldBeginDoc,
+                           oldBeginDoc + std::min(oldSize, newSize),
+                           newBeginDoc).first -
+             oldBeginDoc);
+  if (changeBegin == oldSize && oldSize == newSize)
+    return true;
+  size_t suffix = 0;
+  size_t maxSuffix = std::min(oldSize, newSize) - changeBegin;
+  while (suffix < maxSuffix &&
+         oldEndDoc[-1 - ptrdiff_t(suffix)] == newEndDoc[-1 - ptrdiff_t(suffix)])
+    ++suffix;
+  size_t oldChangeEnd = oldSize - suffix;
+  size_t delta = newSize - oldSize; // modulo arithmetic
+
+  // Values enclosing the edit, from the root down.
+  std::vector<Value*> enclosing;
+  for (Value* value = &root;;) {
+    enclosing.push_back(value);
+    Value* child = 0;
+    if (value->isArray() || value->isObject()) {
+      for (Value::iterator it = value->begin(); it != value->end(); ++it) {
+        if ((*it).getOffsetStart() <= changeBegin &&
+            oldChangeEnd <= (*it).getOffsetLimit()) {
+          child = &*it;
+          break;
+        }
+      }
+    }
+    if (!child)
+      break;
+    value = child;
+  }
+
+  // Try the innermost value first. Its new text must parse as exactly one
+  // value, otherwise the edit changed the structure around it and the
+  // enclosing value is tried next. The root is parsed as a whole document.
+  for (size_t index = enclosing.size() - 1; index != 0; --index) {
+    Value& target = *enclosing[index];
+    size_t start = target.getOffsetStart();
+    size_t oldLimit = target.getOffsetLimit();
+    size_t newLimit = oldLimit + delta;
+    const char* begin = newBeginDoc + start;
+    const char* end = newBeginDoc + newLimit;
+    if (collectComments &&
+        (memchr(begin, '/', newLimit - start) ||
+         memchr(oldBeginDoc + start, '/', oldLimit - start)))
+      break;
+    Value replacement;
+    if (!parse(begin, end, replacement, collectComments) ||
+        replacement.getOffsetStart() != 0 ||
+        replacement.getOffsetLimit() != newLimit - start)
+      continue;
+    shiftOffsets(replacement, start);
+    if (delta != 0)
+      moveOffsetsAfter(root, target, oldLimit, delta);
+    // The comments of target lie outside of its text and are kept.
+    target.swapPayload(replacement);
+    target.setOffsetLimit(newLimit);
+    return true;
+  }
+  return parseAgain(newBeginDoc, newEndDoc, root, collectComments);
+}
+
+bool Reader::parseAgain(const char* beginDoc,
+                        const char* endDoc,
+                        Value& root,
+                        bool collectComments) {
+  // Parse into a new Value: parse() keeps the comments of the root.
+  Value fresh;
+  bool successful = parse(beginDoc, endDoc, fresh, collectComments);
+  root.swap(fresh);
+  return successful;
+}
+
+void Reader::startDocument(Value& root, bool collectComments) {
+  while (!nodes_.empty())
+    nodes_.pop();
+  member_ = &root;
+#if defined(JSON_COMPACT_VALUE)
+  // Offsets take a side table record per value: only keep them when the
+  // comments need them to be placed.
+  storeOffsets_ = collectComments;
+#else
+  (void)collectComments;
+  storeOffsets_ = true;
+#endif
+  lastValue_ = 0;
+  lastParent_ = 0;
+  lastMoved_ = false;
+  commentsBefore_ = "";
+}
+
+bool Reader::endDocument(Value& root, bool successful) {
+  // After an error, the objects still open keep what was read of them.
+  for (; !nodes_.empty(); nodes_.pop())
+    nodes_.top()->sortMembers();
+  // Comments that no value followed belong to the whole document.
+  if (!commentsBefore_.empty())
+    root.setComment(commentsBefore_.data(), commentsBefore_.size(),
+                    commentAfter, resource_);
+  return successful;
+}
+
+Value& Reader::nextValue() {
+  Value* value;
+  if (!nodes_.empty() && nodes_.top()->type() == arrayValue) {
+    Value& array = *nodes_.top();
+    value = &array.append(nullValue);
+    addedTo(array);
+  } else {
+    // The root, or the object member named by the last onKey().
+    value = member_;
+  }
+  if (!commentsBefore_.empty()) {
+    value->setComment(commentsBefore_.data(), commentsBefore_.size(),
+                      commentBefore, resource_);
+    commentsBefore_ = "";
+  }
+  return *value;
+}
+
+void Reader::setValue(Value& decoded) {
+  Value& value = nextValue();
+  value.swapPayload(decoded);
+  if (storeOffsets_) {
+    value.setOffsetStart(sax_.getOffsetStart());
+    value.setOffsetLimit(sax_.getOffsetLimit());
+  }
+  setLastValue(value);
+}
+
+void Reader::beginContainer(ValueType type) {
+  Value& value = nextValue();
+  if (resource_) {
+    Value init(type, *resource_);
+    value.swapPayload(init);
+  } else {
+    Value init(type);
+    value.swapPayload(init);
+  }
+  if (storeOffsets_)
+    value.setOffsetStart(sax_.getOffsetStart());
+  nodes_.push(&value);
+}
+
+void Reader::endContainer() {
+  Value& value = *nodes_.top();
+  nodes_.pop();
+  value.sortMembers();
+  if (storeOffsets_)
+    value.setOffsetLimit(sax_.getOffsetLimit());
+  setLastValue(value);
+}
+
+void Reader::setLastValue(Value& value) {
+  lastValue_ = &value;
+  lastParent_ = nodes_.empty() ? 0 : nodes_.top();
+  lastStart_ = value.getOffsetStart();
+  lastMoved_ = false;
+}
+
+void Reader::addedTo(const Value& container) {
+  if (&container == lastParent_)
+    lastMoved_ = true;
+}
+
+Value* Reader::lastValue() {
+  if (lastMoved_) {
+    lastMoved_ = false;
+    lastValue_ = 0;
+    for (Value::iterator it = lastParent_->begin(); it != lastParent_->end();
+         ++it) {
+      if ((*it).getOffsetStart() == lastStart_) {
+        lastValue_ = &*it;
+        break;
+      }
+    }
+  }
+  return lastValue_;
+}
+
+void Reader::onNull() {
+  Value decoded;
+  setValue(decoded);
+}
+
+void Reader::onBool(bool value) {
+  Value decoded(value);
+  setValue(decoded);
+}
+
+void Reader::onInt(LargestInt value) {
+  Value decoded(value);
+  setValue(decoded);
+}
+
+void Reader::onUInt(LargestUInt value) {
+  // Keep small values signed, as they always were.
+  Value decoded = value <= LargestUInt(Value::maxInt) ? Value(LargestInt(value))
+                                                      : Value(value);
+  setValue(decoded);
+}
+
+void Reader::onDouble(double value) {
+  Value decoded(value);
+  setValue(decoded);
+}
+
+void Reader::onString(const char* begin, const char* end) {
+  if (resource_) {
+    Value decoded(begin, end, *resource_);
+    setValue(decoded);
+    return;
+  }
+  Value decoded(begin, end);
+  setValue(decoded);
+}
+
+void Reader::onObjectBegin() { beginContainer(objectValue); }
+
+void Reader::onKey(const char* begin, const char* end) {
+  Value& object = *nodes_.top();
+  ArrayIndex size = object.size();
+  if (keyTable_) {
+    StaticString name(keyTable_->intern(begin, size_t(end - begin)));
+    member_ = &object.addMember(name);
+  } else {
+    member_ = &object.addMember(std::string(begin, end));
+  }
+  // A repeated name reuses its member, which moves nothing.
+  if (object.size() != size)
+    addedTo(object);
+}
+
+void Reader::onObjectEnd() { endContainer(); }
+
+void Reader::onArrayBegin() { beginContainer(arrayValue); }
+
+void Reader::onArrayEnd() { endContainer(); }
+
+void
+Reader::onComment(const char* begin, const char* end, CommentPlacement placement) {
+  const std::string& normalized = normalizeEOL(begin, end);
+  Value* last = placement == commentAfterOnSameLine ? lastValue() : 0;
+  if (last) {
+    last->setComment(normalized.data(), normalized.size(), placement,
+                     resource_);
+  } else {
+    commentsBefore_ += normalized;
+  }
+}
+
+// Deprecated. Preserved for backward compatibility
+std::string Reader::getFormatedErrorMessages() const {
+  return getFormattedErrorMessages();
+}
+
+std::string Reader::getFormattedErrorMessages() const {
+  return sax_.getFormattedErrorMessages();
+}
+
+std::vector<Reader::StructuredError> Reader::getStructuredErrors() const {
+  return sax_.getStructuredErrors();
+}
+
+bool Reader::pushError(const Value& value, const std::string& message) {
+  return sax_.pushError(value, message);
+}
+
+bool Reader::pushError(const Value& value,
+                       const std::string& message,
+                       const Value& extra) {
+  return sax_.pushError(value, message, extra);
+}
+
+bool Reader::good() const { return sax_.good(); }
+
 class OldReader : public CharReader {
   bool const collectComments_;
   Reader reader_;
@@ -929,9 +1828,9 @@ bool parseFromStream(
     CharReader::Factory const& fact, std::istream& sin,
     Value* root, std::string* errs)
 {
-  std::ostringstream ssin;
-  ssin << sin.rdbuf();
-  std::string doc = ssin.str();
+  // Copy the stream once, straight into the buffer that is parsed.
+  std::string doc((std::istreambuf_iterator<char>(sin)),
+                  std::istreambuf_iterator<char>());
   char const* begin = doc.data();
   char const* end = begin + doc.size();
   // Note that we do not actually need a null-terminator.
@@ -0,0 +1,208 @@
+// Copyright 2007-2011 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include <json/arena.h>
+#include <json/resource.h>
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cstring>
+
+#if JSON_HAS_STD_THREAD
+#include <mutex>
+#endif
+
+namespace Json {
+
+// Requests are rounded up to a multiple of 16 bytes up to 128 bytes, then
+// to a power of two up to maxPooledSize (4096 bytes).
+enum { smallClassCount = 8, sizeClassCount = smallClassCount + 5 };
+
+static inline size_t sizeClassOf(size_t size) {
+  if (size <= 16 * smallClassCount)
+    return size == 0 ? 0 : (size - 1) / 16;
+  size_t sizeClass = smallClassCount;
+  for (size_t classSize = 32 * smallClassCount; classSize < size;
+       classSize *= 2)
+    ++sizeClass;
+  return sizeClass;
+}
+
+static inline size_t sizeOfClass(size_t sizeClass) {
+  if (sizeClass < smallClassCount)
+    return 16 * (sizeClass + 1);
+  return (32 * smallClassCount) << (sizeClass - smallClassCount);
+}
+
+// A free block, linked to the next free block of its size class.
+struct FreeBlock {
+  FreeBlock* next_;
+};
+
+// Implementation of class MemoryResource
+// ////////////////////////////////
+
+MemoryResource::~MemoryResource() {}
+
+char* MemoryResource::duplicate(const char* begin, size_t length) {
+  char* text = static_cast<char*>(allocate(length + 1));
+  memcpy(text, begin, length);
+  text[length] = 0;
+  return text;
+}
+
+// Implementation of class PoolResource
+// ////////////////////////////////
+
+/* Blocks are carved one at a time from the chunks of an arena, and only go
+ * back to it all at once.
+ */
+struct PoolResource::Impl {
+  explicit Impl(size_t chunkSize) : chunks_(chunkSize) { clear(); }
+
+  void clear() {
+    for (size_t sizeClass = 0; sizeClass < sizeClassCount; ++sizeClass)
+      free_[sizeClass] = 0;
+  }
+
+  ValueArena chunks_;
+  FreeBlock* free_[sizeClassCount];
+#if JSON_HAS_STD_THREAD
+  std::mutex mutex_;
+#endif
+};
+
+PoolResource::PoolResource(size_t chunkSize) : impl_(new Impl(chunkSize)) {}
+
+PoolResource::~PoolResource() { delete impl_; }
+
+void PoolResource::release() {
+#if JSON_HAS_STD_THREAD
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+#endif
+  impl_->chunks_.release();
+  impl_->clear();
+}
+
+void* PoolResource::doAllocate(size_t size) {
+  if (size > maxPooledSize)
+    return ::operator new(size);
+  size_t sizeClass = sizeClassOf(size);
+#if JSON_HAS_STD_THREAD
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+#endif
+  FreeBlock* block = impl_->free_[sizeClass];
+  if (!block)
+    return impl_->chunks_.allocate(sizeOfClass(sizeClass));
+  impl_->free_[sizeClass] = block->next_;
+  return block;
+}
+
+void PoolResource::doDeallocate(void* memory, size_t size) {
+  if (size > maxPooledSize) {
+    ::operator delete(memory);
+    return;
+  }
+  size_t sizeClass = sizeClassOf(size);
+  FreeBlock* block = static_cast<FreeBlock*>(memory);
+#if JSON_HAS_STD_THREAD
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+#endif
+  block->next_ = impl_->free_[sizeClass];
+  impl_->free_[sizeClass] = block;
+}
+
+// Implementation of class ThreadLocalPoolResource
+// ////////////////////////////////
+
+#if JSON_HAS_THREAD_LOCAL
+
+namespace {
+
+/* Free blocks of the calling thread. It has no destructor, so that it can
+ * still be used while the thread_local objects of the thread, which may
+ * hold Values, are destroyed: ThreadCacheCleanup empties it first, and
+ * blocks freed after that go straight to operator delete.
+ */
+struct ThreadCache {
+  FreeBlock* free_[sizeClassCount];
+  unsigned int counts_[sizeClassCount];
+  bool registered_;
+  bool closed_;
+};
+
+thread_local ThreadCache threadCache;
+
+struct ThreadCacheCleanup {
+  ~ThreadCacheCleanup() {
+    ThreadCache& cache = threadCache;
+    cache.closed_ = true;
+    for (size_t sizeClass = 0; sizeClass < sizeClassCount; ++sizeClass) {
+      while (FreeBlock* block = cache.free_[sizeClass]) {
+        cache.free_[sizeClass] = block->next_;
+        ::operator delete(block);
+      }
+      cache.counts_[sizeClass] = 0;
+    }
+  }
+};
+
+// Arranges for the cache of the calling thread to be emptied at its exit.
+void registerThreadCacheCleanup() {
+  static thread_local ThreadCacheCleanup cleanup;
+  (void)cleanup;
+}
+
+} // namespace
+
+#endif // if JSON_HAS_THREAD_LOCAL
+
+ThreadLocalPoolResource& ThreadLocalPoolResource::instance() {
+  // Deliberately leaked: Values using it may be destroyed after this
+  // function's statics.
+  static ThreadLocalPoolResource* resource = new ThreadLocalPoolResource();
+  return *resource;
+}
+
+void* ThreadLocalPoolResource::doAllocate(size_t size) {
+#if JSON_HAS_THREAD_LOCAL
+  if (size <= maxPooledSize) {
+    size_t sizeClass = sizeClassOf(size);
+    ThreadCache& cache = threadCache;
+    if (FreeBlock* block = cache.free_[sizeClass]) {
+      cache.free_[sizeClass] = block->next_;
+      --cache.counts_[sizeClass];
+      return block;
+    }
+    // Allocated at the size of its class, to be cached once freed.
+    return ::operator new(sizeOfClass(sizeClass));
+  }
+#endif
+  return ::operator new(size);
+}
+
+void ThreadLocalPoolResource::doDeallocate(void* memory, size_t size) {
+#if JSON_HAS_THREAD_LOCAL
+  if (size <= maxPooledSize) {
+    size_t sizeClass = sizeClassOf(size);
+    ThreadCache& cache = threadCache;
+    if (!cache.closed_ && cache.counts_[sizeClass] < maxCachedBlocks) {
+      if (!cache.registered_) {
+        cache.registered_ = true;
+        registerThreadCacheCleanup();
+      }
+      FreeBlock* block = static_cast<FreeBlock*>(memory);
+      block->next_ = cache.free_[sizeClass];
+      cache.free_[sizeClass] = block;
+      ++cache.counts_[sizeClass];
+      return;
+    }
+  }
+#else
+  (void)size;
+#endif
+  ::operator delete(memory);
+}
+
+} // namespace Json
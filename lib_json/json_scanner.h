@@ -0,0 +1,526 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef LIB_JSONCPP_JSON_SCANNER_H_INCLUDED
+#define LIB_JSONCPP_JSON_SCANNER_H_INCLUDED
+
+/* This header provides the byte scanning loops used by the Reader tokenizer:
+ * skipping whitespace, finding the end of a string, the end of a run of
+ * digits, the next bracket of a value being skipped and the next non-ASCII
+ * byte of a string being validated. The writers use it to find the next
+ * character of a string that must be escaped. Each scanner has a scalar version and,
+ * on x86, SSE2 and AVX2 versions that look at 16 or 32 bytes at a time. The
+ * widest one supported by the running CPU is selected the first time a
+ * scanner is used.
+ *
+ * All scanners take a [begin, end) range, never read outside of it, and
+ * return a pointer to the first byte that stops the scan (or end).
+ *
+ * It is an internal header that must not be exposed.
+ */
+
+#if defined(_M_X64) || defined(__x86_64__) ||                                 \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define JSON_SCANNER_HAS_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#define JSON_SCANNER_HAS_AVX2 1
+#define JSON_SCANNER_AVX2_TARGET
+#elif defined(__GNUC__) && (defined(__clang__) || __GNUC__ >= 5)
+#include <immintrin.h>
+#define JSON_SCANNER_HAS_AVX2 1
+#define JSON_SCANNER_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Json {
+
+// Scalar scanners
+// //////////////////////////////////////////////////////////////////
+
+static inline bool isJsonSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool isJsonDigit(char c) { return c >= '0' && c <= '9'; }
+
+static inline const char* scanSpacesScalar(const char* p, const char* end) {
+  while (p != end && isJsonSpace(*p))
+    ++p;
+  return p;
+}
+
+static inline const char* scanStringSpecialScalar(const char* p,
+                                                  const char* end) {
+  while (p != end && *p != '"' && *p != '\\')
+    ++p;
+  return p;
+}
+
+static inline const char* scanDigitsScalar(const char* p, const char* end) {
+  while (p != end && isJsonDigit(*p))
+    ++p;
+  return p;
+}
+
+static inline const char* scanAsciiScalar(const char* p, const char* end) {
+  while (p != end && static_cast<unsigned char>(*p) < 0x80)
+    ++p;
+  return p;
+}
+
+static inline bool needsEscape(char c) {
+  return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+static inline const char* scanEscapeScalar(const char* p, const char* end) {
+  while (p != end && !needsEscape(*p))
+    ++p;
+  return p;
+}
+
+static inline bool isJsonStructural(char c) {
+  return c == '"' || c == '/' || c == '{' || c == '}' || c == '[' || c == ']';
+}
+
+static inline const char* scanStructuralScalar(const char* p,
+                                               const char* end) {
+  while (p != end && !isJsonStructural(*p))
+    ++p;
+  return p;
+}
+
+#if defined(JSON_SCANNER_HAS_SSE2)
+
+/// Index of the lowest set bit; \a mask must not be zero.
+static inline unsigned int lowestBitIndex(unsigned int mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned int>(index);
+#else
+  return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+// SSE2 scanners, 16 bytes per step
+// //////////////////////////////////////////////////////////////////
+
+static inline __m128i spaceMask16(__m128i chunk) {
+  __m128i m = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+  m = _mm_or_si128(m, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+  m = _mm_or_si128(m, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+  return _mm_or_si128(m, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+}
+
+static inline __m128i stringSpecialMask16(__m128i chunk) {
+  return _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+                      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+}
+
+static inline __m128i escapeMask16(__m128i chunk) {
+  // Control characters are the bytes c with min(c, 0x1F) == c.
+  __m128i control = _mm_cmpeq_epi8(
+      _mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk);
+  return _mm_or_si128(stringSpecialMask16(chunk), control);
+}
+
+static inline __m128i digitMask16(__m128i chunk) {
+  // c - '0' <= 9, as an unsigned byte comparison.
+  __m128i v = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+  return _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(9)), v);
+}
+
+static inline __m128i structuralMask16(__m128i chunk) {
+  // '[' and ']' only differ from '{' and '}' by bit 0x20.
+  __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+  __m128i m = _mm_cmpeq_epi8(folded, _mm_set1_epi8('{'));
+  m = _mm_or_si128(m, _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+  m = _mm_or_si128(m, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+  return _mm_or_si128(m, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/')));
+}
+
+static inline const char* scanSpacesSse2(const char* p, const char* end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    unsigned int stop = ~_mm_movemask_epi8(spaceMask16(chunk)) & 0xffffu;
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanSpacesScalar(p, end);
+}
+
+static inline const char* scanStringSpecialSse2(const char* p,
+                                                const char* end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    unsigned int stop = _mm_movemask_epi8(stringSpecialMask16(chunk));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanStringSpecialScalar(p, end);
+}
+
+static inline const char* scanEscapeSse2(const char* p, const char* end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    unsigned int stop = _mm_movemask_epi8(escapeMask16(chunk));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanEscapeScalar(p, end);
+}
+
+static inline const char* scanDigitsSse2(const char* p, const char* end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    unsigned int stop = ~_mm_movemask_epi8(digitMask16(chunk)) & 0xffffu;
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanDigitsScalar(p, end);
+}
+
+static inline const char* scanAsciiSse2(const char* p, const char* end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    unsigned int stop = _mm_movemask_epi8(chunk);
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanAsciiScalar(p, end);
+}
+
+static inline const char* scanStructuralSse2(const char* p, const char* end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    unsigned int stop = _mm_movemask_epi8(structuralMask16(chunk));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanStructuralScalar(p, end);
+}
+
+#endif // if defined(JSON_SCANNER_HAS_SSE2)
+
+#if defined(JSON_SCANNER_HAS_AVX2)
+
+// AVX2 scanners, 32 bytes per step
+// //////////////////////////////////////////////////////////////////
+
+JSON_SCANNER_AVX2_TARGET
+static const char* scanSpacesAvx2(const char* p, const char* end) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space),
+                                _mm256_cmpeq_epi8(chunk, tab));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(chunk, cr));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(chunk, lf));
+    unsigned int stop = ~static_cast<unsigned int>(_mm256_movemask_epi8(m));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanSpacesSse2(p, end);
+}
+
+JSON_SCANNER_AVX2_TARGET
+static const char* scanStringSpecialAvx2(const char* p, const char* end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                _mm256_cmpeq_epi8(chunk, backslash));
+    unsigned int stop = static_cast<unsigned int>(_mm256_movemask_epi8(m));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanStringSpecialSse2(p, end);
+}
+
+JSON_SCANNER_AVX2_TARGET
+static const char* scanEscapeAvx2(const char* p, const char* end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i lastControl = _mm256_set1_epi8(0x1F);
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                _mm256_cmpeq_epi8(chunk, backslash));
+    m = _mm256_or_si256(
+        m, _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, lastControl), chunk));
+    unsigned int stop = static_cast<unsigned int>(_mm256_movemask_epi8(m));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanEscapeSse2(p, end);
+}
+
+JSON_SCANNER_AVX2_TARGET
+static const char* scanDigitsAvx2(const char* p, const char* end) {
+  const __m256i zero = _mm256_set1_epi8('0');
+  const __m256i nine = _mm256_set1_epi8(9);
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i v = _mm256_sub_epi8(chunk, zero);
+    __m256i m = _mm256_cmpeq_epi8(_mm256_min_epu8(v, nine), v);
+    unsigned int stop = ~static_cast<unsigned int>(_mm256_movemask_epi8(m));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanDigitsSse2(p, end);
+}
+
+JSON_SCANNER_AVX2_TARGET
+static const char* scanAsciiAvx2(const char* p, const char* end) {
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    unsigned int stop =
+        static_cast<unsigned int>(_mm256_movemask_epi8(chunk));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanAsciiSse2(p, end);
+}
+
+JSON_SCANNER_AVX2_TARGET
+static const char* scanStructuralAvx2(const char* p, const char* end) {
+  const __m256i caseBit = _mm256_set1_epi8(0x20);
+  const __m256i open = _mm256_set1_epi8('{');
+  const __m256i close = _mm256_set1_epi8('}');
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i slash = _mm256_set1_epi8('/');
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i folded = _mm256_or_si256(chunk, caseBit);
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(folded, open),
+                                _mm256_cmpeq_epi8(folded, close));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(chunk, quote));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(chunk, slash));
+    unsigned int stop = static_cast<unsigned int>(_mm256_movemask_epi8(m));
+    if (stop != 0)
+      return p + lowestBitIndex(stop);
+  }
+  return scanStructuralSse2(p, end);
+}
+
+/// Returns \c true if the CPU and the OS both support AVX2.
+static inline bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  // OSXSAVE and AVX, then check that the OS saves the YMM registers.
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+    return false;
+  if ((_xgetbv(0) & 0x6) != 0x6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // if defined(JSON_SCANNER_HAS_AVX2)
+
+// Dispatch
+// //////////////////////////////////////////////////////////////////
+
+enum ScannerLevel {
+  scannerScalar = 0,
+  scannerSse2,
+  scannerAvx2
+};
+
+static inline ScannerLevel detectScannerLevel() {
+#if defined(JSON_SCANNER_HAS_AVX2)
+  if (cpuHasAvx2())
+    return scannerAvx2;
+#endif
+#if defined(JSON_SCANNER_HAS_SSE2)
+  return scannerSse2;
+#else
+  return scannerScalar;
+#endif
+}
+
+static inline ScannerLevel scannerLevel() {
+  static const ScannerLevel level = detectScannerLevel();
+  return level;
+}
+
+/* Runs between tokens are usually short (a single space after ':' or ','),
+ * so each scanner checks the first byte inline and only falls back to the
+ * vector loop for longer runs, such as StyledWriter indentation.
+ */
+
+/// Returns the first byte in [p, end) that is not JSON whitespace.
+static inline const char* scanSpaces(const char* p, const char* end) {
+  if (p == end || !isJsonSpace(*p))
+    return p;
+  ++p;
+  switch (scannerLevel()) {
+#if defined(JSON_SCANNER_HAS_AVX2)
+  case scannerAvx2:
+    return scanSpacesAvx2(p, end);
+#endif
+#if defined(JSON_SCANNER_HAS_SSE2)
+  case scannerSse2:
+    return scanSpacesSse2(p, end);
+#endif
+  default:
+    return scanSpacesScalar(p, end);
+  }
+}
+
+/// Returns the first '"' or '\\' in [p, end).
+static inline const char* scanStringSpecial(const char* p, const char* end) {
+  switch (scannerLevel()) {
+#if defined(JSON_SCANNER_HAS_AVX2)
+  case scannerAvx2:
+    return scanStringSpecialAvx2(p, end);
+#endif
+#if defined(JSON_SCANNER_HAS_SSE2)
+  case scannerSse2:
+    return scanStringSpecialSse2(p, end);
+#endif
+  default:
+    return scanStringSpecialScalar(p, end);
+  }
+}
+
+/// Returns the first '"', '\\' or control character in [p, end), the
+/// bytes that must be escaped in a JSON string.
+static inline const char* scanEscape(const char* p, const char* end) {
+  switch (scannerLevel()) {
+#if defined(JSON_SCANNER_HAS_AVX2)
+  case scannerAvx2:
+    return scanEscapeAvx2(p, end);
+#endif
+#if defined(JSON_SCANNER_HAS_SSE2)
+  case scannerSse2:
+    return scanEscapeSse2(p, end);
+#endif
+  default:
+    return scanEscapeScalar(p, end);
+  }
+}
+
+/// Returns the first byte in [p, end) that is not a decimal digit.
+static inline const char* scanDigits(const char* p, const char* end) {
+  if (p == end || !isJsonDigit(*p))
+    return p;
+  ++p;
+  switch (scannerLevel()) {
+#if defined(JSON_SCANNER_HAS_AVX2)
+  case scannerAvx2:
+    return scanDigitsAvx2(p, end);
+#endif
+#if defined(JSON_SCANNER_HAS_SSE2)
+  case scannerSse2:
+    return scanDigitsSse2(p, end);
+#endif
+  default:
+    return scanDigitsScalar(p, end);
+  }
+}
+
+/// Returns the first '"', '/' or bracket in [p, end), the bytes that matter
+/// when skipping over a value without decoding it.
+static inline const char* scanStructural(const char* p, const char* end) {
+  switch (scannerLevel()) {
+#if defined(JSON_SCANNER_HAS_AVX2)
+  case scannerAvx2:
+    return scanStructuralAvx2(p, end);
+#endif
+#if defined(JSON_SCANNER_HAS_SSE2)
+  case scannerSse2:
+    return scanStructuralSse2(p, end);
+#endif
+  default:
+    return scanStructuralScalar(p, end);
+  }
+}
+
+/// Returns the first byte in [p, end) that is not ASCII.
+static inline const char* scanAscii(const char* p, const char* end) {
+  switch (scannerLevel()) {
+#if defined(JSON_SCANNER_HAS_AVX2)
+  case scannerAvx2:
+    return scanAsciiAvx2(p, end);
+#endif
+#if defined(JSON_SCANNER_HAS_SSE2)
+  case scannerSse2:
+    return scanAsciiSse2(p, end);
+#endif
+  default:
+    return scanAsciiScalar(p, end);
+  }
+}
+
+/** Returns the first byte of the first invalid UTF-8 sequence in [p, end),
+ * or end. Runs of ASCII are skipped with scanAscii(); multi-byte sequences
+ * are checked against the well-formed ranges of the Unicode standard (table
+ * 3-7), which excludes overlong forms, surrogates and code points above
+ * U+10FFFF.
+ */
+static inline const char* validateUTF8(const char* p, const char* end) {
+  for (;;) {
+    p = scanAscii(p, end);
+    if (p == end)
+      return end;
+    // Text in other scripts chains multi-byte sequences: only go back to
+    // scanAscii() once an ASCII byte is found.
+    do {
+      unsigned char lead = static_cast<unsigned char>(*p);
+      unsigned char low = 0x80; // range of the second byte
+      unsigned char high = 0xBF;
+      int length;
+      if (lead < 0xC2) {
+        return p; // continuation byte, or overlong two-byte form
+      } else if (lead < 0xE0) {
+        length = 2;
+      } else if (lead < 0xF0) {
+        length = 3;
+        if (lead == 0xE0)
+          low = 0xA0;
+        else if (lead == 0xED)
+          high = 0x9F;
+      } else if (lead < 0xF5) {
+        length = 4;
+        if (lead == 0xF0)
+          low = 0x90;
+        else if (lead == 0xF4)
+          high = 0x8F;
+      } else {
+        return p;
+      }
+      if (end - p < length)
+        return p;
+      unsigned char second = static_cast<unsigned char>(p[1]);
+      if (second < low || second > high)
+        return p;
+      for (int index = 2; index < length; ++index) {
+        if ((static_cast<unsigned char>(p[index]) & 0xC0) != 0x80)
+          return p;
+      }
+      p += length;
+    } while (p != end && static_cast<unsigned char>(*p) >= 0x80);
+  }
+}
+
+} // namespace Json
+
+#endif // LIB_JSONCPP_JSON_SCANNER_H_INCLUDED
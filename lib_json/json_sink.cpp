@@ -0,0 +1,79 @@
+// Copyright 2007-2011 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include <json/sink.h>
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Json {
+
+// Implementation of class OutputSink
+// ////////////////////////////////
+
+OutputSink::~OutputSink() {}
+
+// Implementation of class StringSink
+// ////////////////////////////////
+
+void StringSink::write(const char* data, size_t length) {
+  document_.append(data, length);
+}
+
+// Implementation of class StreamSink
+// ////////////////////////////////
+
+void StreamSink::write(const char* data, size_t length) {
+  stream_.write(data, std::streamsize(length));
+}
+
+// Implementation of class FileSink
+// ////////////////////////////////
+
+void FileSink::write(const char* data, size_t length) {
+  fwrite(data, 1, length, file_);
+}
+
+// Implementation of class FdSink
+// ////////////////////////////////
+
+void FdSink::write(const char* data, size_t length) {
+  while (good_ && length != 0) {
+#if defined(_WIN32)
+    // _write() takes an unsigned int count.
+    unsigned int chunk = length > 0x40000000 ? 0x40000000 : (unsigned int)length;
+    int written = ::_write(fd_, data, chunk);
+#else
+    ssize_t written = ::write(fd_, data, length);
+#endif
+    if (written < 0) {
+      if (errno != EINTR)
+        good_ = false;
+      continue;
+    }
+    data += written;
+    length -= size_t(written);
+  }
+}
+
+// Implementation of class MemorySink
+// ////////////////////////////////
+
+void MemorySink::write(const char* data, size_t length) {
+  if (size_ < capacity_) {
+    size_t room = capacity_ - size_;
+    memcpy(begin_ + size_, data, length < room ? length : room);
+  }
+  size_ += length;
+}
+
+} // namespace Json
@@ -14,32 +14,38 @@
 
 namespace Json {
 
-/// Converts a unicode code-point to UTF-8.
-static inline std::string codePointToUTF8(unsigned int cp) {
-  std::string result;
-
+/// Appends the UTF-8 encoding of the code point \a cp to \a out.
+static inline void appendUTF8(unsigned int cp, std::string& out) {
   // based on description from http://en.wikipedia.org/wiki/UTF-8
 
+  char buffer[4];
+  size_t length = 0;
   if (cp <= 0x7f) {
-    result.resize(1);
-    result[0] = static_cast<char>(cp);
+    buffer[0] = static_cast<char>(cp);
+    length = 1;
   } else if (cp <= 0x7FF) {
-    result.resize(2);
-    result[1] = static_cast<char>(0x80 | (0x3f & cp));
-    result[0] = static_cast<char>(0xC0 | (0x1f & (cp >> 6)));
+    buffer[1] = static_cast<char>(0x80 | (0x3f & cp));
+    buffer[0] = static_cast<char>(0xC0 | (0x1f & (cp >> 6)));
+    length = 2;
   } else if (cp <= 0xFFFF) {
-    result.resize(3);
-    result[2] = static_cast<char>(0x80 | (0x3f & cp));
-    result[1] = 0x80 | static_cast<char>((0x3f & (cp >> 6)));
-    result[0] = 0xE0 | static_cast<char>((0xf & (cp >> 12)));
+    buffer[2] = static_cast<char>(0x80 | (0x3f & cp));
+    buffer[1] = static_cast<char>(0x80 | (0x3f & (cp >> 6)));
+    buffer[0] = static_cast<char>(0xE0 | (0xf & (cp >> 12)));
+    length = 3;
   } else if (cp <= 0x10FFFF) {
-    result.resize(4);
-    result[3] = static_cast<char>(0x80 | (0x3f & cp));
-    result[2] = static_cast<char>(0x80 | (0x3f & (cp >> 6)));
-    result[1] = static_cast<char>(0x80 | (0x3f & (cp >> 12)));
-    result[0] = static_cast<char>(0xF0 | (0x7 & (cp >> 18)));
+    buffer[3] = static_cast<char>(0x80 | (0x3f & cp));
+    buffer[2] = static_cast<char>(0x80 | (0x3f & (cp >> 6)));
+    buffer[1] = static_cast<char>(0x80 | (0x3f & (cp >> 12)));
+    buffer[0] = static_cast<char>(0xF0 | (0x7 & (cp >> 18)));
+    length = 4;
   }
+  out.append(buffer, length);
+}
 
+/// Converts a unicode code-point to UTF-8.
+static inline std::string codePointToUTF8(unsigned int cp) {
+  std::string result;
+  appendUTF8(cp, result);
   return result;
 }
 
@@ -61,11 +67,65 @@ typedef char UIntToStringBuffer[uintToStringBufferSize];
  *        Must have at least uintToStringBufferSize chars free.
  */
 static inline void uintToString(LargestUInt value, char*& current) {
+  // Two digits per division, looked up in a table of all the pairs.
+  static const char digitPairs[] = "00010203040506070809"
+                                   "10111213141516171819"
+                                   "20212223242526272829"
+                                   "30313233343536373839"
+                                   "40414243444546474849"
+                                   "50515253545556575859"
+                                   "60616263646566676869"
+                                   "70717273747576777879"
+                                   "80818283848586878889"
+                                   "90919293949596979899";
   *--current = 0;
-  do {
-    *--current = char(value % 10) + '0';
-    value /= 10;
-  } while (value != 0);
+  while (value >= 100) {
+    const char* pair = digitPairs + 2 * (value % 100);
+    value /= 100;
+    *--current = pair[1];
+    *--current = pair[0];
+  }
+  if (value >= 10) {
+    const char* pair = digitPairs + 2 * value;
+    *--current = pair[1];
+    *--current = pair[0];
+  } else {
+    *--current = char(value) + '0';
+  }
+}
+
+#if defined(JSON_HAS_INT64)
+/** Converts 8 ASCII decimal digits to their value, all at once (SWAR).
+ * @param digits Pointer to exactly 8 digits, no validation is done.
+ */
+static inline UInt eightDigitsToUInt(const char* digits) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(digits);
+  // Assemble as little endian whatever the host is; compilers turn this into
+  // a single load on little endian machines.
+  UInt64 chunk = UInt64(p[0]) | (UInt64(p[1]) << 8) | (UInt64(p[2]) << 16) |
+                 (UInt64(p[3]) << 24) | (UInt64(p[4]) << 32) |
+                 (UInt64(p[5]) << 40) | (UInt64(p[6]) << 48) |
+                 (UInt64(p[7]) << 56);
+  // Combine pairs of digits, then pairs of pairs, then the two halves.
+  chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+  chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  return UInt(((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+#endif // if defined(JSON_HAS_INT64)
+
+/** Converts a run of ASCII decimal digits to an unsigned integer.
+ * The caller must make sure the value fits in a LargestUInt.
+ */
+static inline LargestUInt decimalDigitsToUInt(const char* begin,
+                                              const char* end) {
+  LargestUInt value = 0;
+#if defined(JSON_HAS_INT64)
+  for (; end - begin >= 8; begin += 8)
+    value = value * 100000000u + eightDigitsToUInt(begin);
+#endif // if defined(JSON_HAS_INT64)
+  for (; begin != end; ++begin)
+    value = value * 10 + UInt(*begin - '0');
+  return value;
 }
 
 /** Change ',' to '.' everywhere in buffer.
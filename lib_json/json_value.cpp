@@ -6,6 +6,7 @@
 #if !defined(JSON_IS_AMALGAMATION)
 #include <json/assertions.h>
 #include <json/value.h>
+#include <json/keytable.h>
 #include <json/writer.h>
 #ifndef JSON_USE_SIMPLE_INTERNAL_ALLOCATOR
 #include "json_batchallocator.h"
@@ -20,6 +21,13 @@
 #include <cpptl/conststring.h>
 #endif
 #include <cstddef> // size_t
+#include <vector>
+#if JSON_HAS_STD_THREAD
+#include <mutex>
+#if defined(JSON_COPY_ON_WRITE)
+#include <atomic>
+#endif
+#endif
 
 #define JSON_ASSERT_UNREACHABLE assert(false)
 
@@ -106,6 +114,225 @@ static inline char* duplicateStringValue(const char* value,
  */
 static inline void releaseStringValue(char* value) { free(value); }
 
+/* Strings allocated from a MemoryResource start with a header telling where
+ * to give them back, since the Values holding them have no room for it.
+ */
+struct ResourceStringHeader {
+  MemoryResource* resource_;
+  size_t size_;
+};
+
+/** Duplicates [value, value + length) into resource, for
+ * releaseResourceString().
+ */
+static inline char* duplicateResourceString(MemoryResource& resource,
+                                            const char* value,
+                                            size_t length) {
+  size_t size = sizeof(ResourceStringHeader) + length + 1;
+  ResourceStringHeader* header =
+      static_cast<ResourceStringHeader*>(resource.allocate(size));
+  header->resource_ = &resource;
+  header->size_ = size;
+  char* newString = reinterpret_cast<char*>(header + 1);
+  memcpy(newString, value, length);
+  newString[length] = 0;
+  return newString;
+}
+
+/** Free the string duplicated by duplicateResourceString().
+ */
+static inline void releaseResourceString(char* value) {
+  ResourceStringHeader* header =
+      reinterpret_cast<ResourceStringHeader*>(value) - 1;
+  header->resource_->deallocate(header, header->size_);
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class ValueArena
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// Alignment of arena allocations, enough for every member of a Value and of
+// the map nodes holding them.
+static const size_t arenaAlignment =
+    sizeof(LargestUInt) > sizeof(void*) ? sizeof(LargestUInt) : sizeof(void*);
+
+// Blocks stop growing past this size.
+static const size_t maxArenaBlockSize = 1024 * 1024;
+
+ValueArena::ValueArena(size_t blockSize)
+    : MemoryResource(true), blocks_(0), current_(0), end_(0),
+      blockSize_(blockSize) {
+  if (blockSize_ < 2 * sizeof(Block))
+    blockSize_ = 2 * sizeof(Block);
+}
+
+ValueArena::~ValueArena() {
+  while (blocks_) {
+    Block* next = blocks_->next_;
+    ::operator delete(blocks_);
+    blocks_ = next;
+  }
+}
+
+void* ValueArena::allocate(size_t size) {
+  size = (size + arenaAlignment - 1) & ~(arenaAlignment - 1);
+  if (size == 0)
+    size = arenaAlignment;
+  if (size_t(end_ - current_) < size)
+    return allocateBlock(size);
+  void* memory = current_;
+  current_ += size;
+  return memory;
+}
+
+void* ValueArena::allocateBlock(size_t size) {
+  size_t blockSize = blockSize_;
+  while (blockSize - sizeof(Block) < size)
+    blockSize *= 2;
+  if (blockSize_ < maxArenaBlockSize)
+    blockSize_ *= 2;
+
+  Block* block = static_cast<Block*>(::operator new(blockSize));
+  block->next_ = blocks_;
+  block->size_ = blockSize;
+  blocks_ = block;
+  current_ = reinterpret_cast<char*>(block + 1) + size;
+  end_ = reinterpret_cast<char*>(block) + blockSize;
+  return block + 1;
+}
+
+void* ValueArena::doAllocate(size_t size) { return allocate(size); }
+
+void ValueArena::doDeallocate(void*, size_t) {
+  // Freed with the other allocations by release().
+}
+
+void ValueArena::release() {
+  Block* largest = blocks_;
+  for (Block* block = blocks_; block; block = block->next_) {
+    if (block->size_ > largest->size_)
+      largest = block;
+  }
+  while (blocks_) {
+    Block* next = blocks_->next_;
+    if (blocks_ != largest)
+      ::operator delete(blocks_);
+    blocks_ = next;
+  }
+  if (largest) {
+    largest->next_ = 0;
+    blocks_ = largest;
+    current_ = reinterpret_cast<char*>(largest + 1);
+    end_ = reinterpret_cast<char*>(largest) + largest->size_;
+  }
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class KeyTable
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+/* Open addressing hash set of names, with linear probing. Names are copied
+ * into an arena, so they never move and are all freed with the table.
+ */
+struct KeyTable::Impl {
+  struct Slot {
+    const char* name_;
+    size_t length_;
+    size_t hash_;
+  };
+
+  Impl() : names_(), slots_(64), count_(0) {}
+
+  Slot& find(const char* name, size_t length, size_t hash) {
+    size_t mask = slots_.size() - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+      Slot& slot = slots_[index];
+      if (!slot.name_ || (slot.hash_ == hash && slot.length_ == length &&
+                          memcmp(slot.name_, name, length) == 0))
+        return slot;
+    }
+  }
+
+  void grow() {
+    std::vector<Slot> slots(slots_.size() * 2);
+    slots.swap(slots_);
+    for (size_t index = 0; index < slots.size(); ++index) {
+      if (slots[index].name_)
+        find(slots[index].name_, slots[index].length_, slots[index].hash_) =
+            slots[index];
+    }
+  }
+
+  ValueArena names_;
+  std::vector<Slot> slots_;
+  size_t count_;
+#if JSON_HAS_STD_THREAD
+  std::mutex mutex_;
+#endif
+};
+
+// FNV-1a
+static size_t hashName(const char* name, size_t length) {
+  size_t hash = sizeof(size_t) > 4 ? size_t(14695981039346656037ULL)
+                                   : size_t(2166136261U);
+  const size_t prime =
+      sizeof(size_t) > 4 ? size_t(1099511628211ULL) : size_t(16777619U);
+  for (size_t index = 0; index < length; ++index)
+    hash = (hash ^ static_cast<unsigned char>(name[index])) * prime;
+  return hash;
+}
+
+KeyTable::KeyTable() : impl_(new Impl()) {}
+
+KeyTable::~KeyTable() { delete impl_; }
+
+KeyTable& KeyTable::shared() {
+  // Deliberately leaked: names may be used by static Values that are
+  // destroyed after this function's statics.
+  static KeyTable* table = new KeyTable();
+  return *table;
+}
+
+const char* KeyTable::intern(const char* begin, size_t length) {
+  size_t hash = hashName(begin, length);
+#if JSON_HAS_STD_THREAD
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+#endif
+  Impl::Slot* slot = &impl_->find(begin, length, hash);
+  if (slot->name_)
+    return slot->name_;
+
+  // Keep the load factor under 1/2.
+  if ((impl_->count_ + 1) * 2 > impl_->slots_.size()) {
+    impl_->grow();
+    slot = &impl_->find(begin, length, hash);
+  }
+  slot->name_ = impl_->names_.duplicate(begin, length);
+  slot->length_ = length;
+  slot->hash_ = hash;
+  ++impl_->count_;
+  return slot->name_;
+}
+
+const char* KeyTable::intern(const char* name) {
+  return intern(name, strlen(name));
+}
+
+size_t KeyTable::size() const {
+#if JSON_HAS_STD_THREAD
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+#endif
+  return impl_->count_;
+}
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////
@@ -134,16 +361,23 @@ namespace Json {
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 
-Value::CommentInfo::CommentInfo() : comment_(0) {}
+Value::CommentInfo::CommentInfo() : comment_(0), fromResource_(false) {}
 
 Value::CommentInfo::~CommentInfo() {
-  if (comment_)
+  if (comment_ && fromResource_)
+    releaseResourceString(comment_);
+  else if (comment_)
     releaseStringValue(comment_);
 }
 
-void Value::CommentInfo::setComment(const char* text, size_t len) {
+void Value::CommentInfo::setComment(const char* text,
+                                    size_t len,
+                                    MemoryResource* resource) {
   if (comment_) {
-    releaseStringValue(comment_);
+    if (fromResource_)
+      releaseResourceString(comment_);
+    else
+      releaseStringValue(comment_);
     comment_ = 0;
   }
   JSON_ASSERT(text != 0);
@@ -151,9 +385,94 @@ void Value::CommentInfo::setComment(const char* text, size_t len) {
       text[0] == '\0' || text[0] == '/',
       "in Json::Value::setComment(): Comments must start with /");
   // It seems that /**/ style comments are acceptable as well.
-  comment_ = duplicateStringValue(text, len);
+  fromResource_ = resource != 0;
+  if (resource)
+    comment_ = duplicateResourceString(*resource, text, len);
+  else
+    comment_ = duplicateStringValue(text, len);
 }
 
+#if defined(JSON_COMPACT_VALUE)
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::MetadataTable
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+/* Metadata of all the Values of the process, found by key. Records are
+ * allocated by chunks that never move, so that a record stays valid while
+ * other threads add theirs. Removed records are chained through their
+ * start_ to be reused.
+ */
+class Value::MetadataTable {
+public:
+  MetadataTable() : chunks_(), size_(0), free_(0) {}
+
+  static MetadataTable& instance() {
+    // Deliberately leaked: static Values may be destroyed after this
+    // function's statics.
+    static MetadataTable* table = new MetadataTable();
+    return *table;
+  }
+
+  /// Adds an empty record and returns its key, never 0.
+  unsigned int add() {
+#if JSON_HAS_STD_THREAD
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    unsigned int key = free_;
+    if (key) {
+      free_ = static_cast<unsigned int>(record(key).start_);
+    } else {
+      JSON_ASSERT_MESSAGE(size_ != maxUInt,
+                          "in Json::Value::MetadataTable::add(): too many "
+                          "values with comments or offsets");
+      if (size_ % chunkSize == 0)
+        chunks_.push_back(new Metadata[chunkSize]);
+      key = ++size_;
+    }
+    Metadata& metadata = record(key);
+    metadata.comments_ = 0;
+    metadata.start_ = 0;
+    metadata.limit_ = 0;
+    return key;
+  }
+
+  Metadata& operator[](unsigned int key) {
+#if JSON_HAS_STD_THREAD
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    return record(key);
+  }
+
+  /// Makes the record of key available to add(). Its comments must have
+  /// been released.
+  void remove(unsigned int key) {
+#if JSON_HAS_STD_THREAD
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    record(key).start_ = free_;
+    free_ = key;
+  }
+
+private:
+  enum { chunkSize = 1024 };
+
+  Metadata& record(unsigned int key) {
+    return chunks_[(key - 1) / chunkSize][(key - 1) % chunkSize];
+  }
+
+  std::vector<Metadata*> chunks_;
+  unsigned int size_;
+  unsigned int free_;
+#if JSON_HAS_STD_THREAD
+  std::mutex mutex_;
+#endif
+};
+#endif // if defined(JSON_COMPACT_VALUE)
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -164,31 +483,62 @@ void Value::CommentInfo::setComment(const char* text, size_t len) {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 
 // Notes: index_ indicates if the string was allocated when
-// a string is stored.
+// a string is stored. Duplicated names that fit in chars_ are stored there
+// (small_), which saves an allocation for most member names.
 
-Value::CZString::CZString(ArrayIndex index) : cstr_(0), index_(index) {}
+Value::CZString::CZString(ArrayIndex index)
+    : cstr_(0), index_(index), small_(false) {}
 
 Value::CZString::CZString(const char* cstr, DuplicationPolicy allocate)
-    : cstr_(allocate == duplicate ? duplicateStringValue(cstr) : cstr),
-      index_(allocate) {}
+    : cstr_(cstr), index_(allocate), small_(false) {
+  if (allocate == duplicate) {
+    size_t length = strlen(cstr);
+    if (length < sizeof(chars_)) {
+      memcpy(chars_, cstr, length + 1);
+      small_ = true;
+    } else {
+      cstr_ = duplicateStringValue(cstr, (unsigned int)length);
+    }
+  }
+}
+
+// Static and arena names are shared by copies, other names are duplicated.
+// Value(const Value&) takes care of not sharing arena names outside of it.
+#if JSON_HAS_RVALUE_REFERENCES
+Value::CZString::CZString(CZString&& other)
+    : cstr_(0), index_(0), small_(false) {
+  swap(other);
+}
+#endif
 
 Value::CZString::CZString(const CZString& other)
-    : cstr_(other.index_ != noDuplication && other.cstr_ != 0
-                ? duplicateStringValue(other.cstr_)
-                : other.cstr_),
-      index_(other.cstr_
-                 ? static_cast<ArrayIndex>(other.index_ == noDuplication
-                     ? noDuplication : duplicate)
-                 : other.index_) {}
+    : cstr_(other.cstr_), index_(other.index_), small_(other.small_) {
+  if (small_) {
+    memcpy(chars_, other.chars_, sizeof(chars_));
+  } else if (cstr_ && index_ != noDuplication && index_ != arenaOwned) {
+    size_t length = strlen(other.cstr_);
+    if (length < sizeof(chars_)) {
+      memcpy(chars_, other.cstr_, length + 1);
+      small_ = true;
+    } else {
+      cstr_ = duplicateStringValue(other.cstr_, (unsigned int)length);
+    }
+    index_ = duplicate;
+  }
+}
 
 Value::CZString::~CZString() {
-  if (cstr_ && index_ == duplicate)
+  if (!small_ && cstr_ && index_ == duplicate)
     releaseStringValue(const_cast<char*>(cstr_));
 }
 
 void Value::CZString::swap(CZString& other) {
-  std::swap(cstr_, other.cstr_);
+  char chars[sizeof(chars_)];
+  memcpy(chars, chars_, sizeof(chars_));
+  memcpy(chars_, other.chars_, sizeof(chars_));
+  memcpy(other.chars_, chars, sizeof(chars_));
   std::swap(index_, other.index_);
+  std::swap(small_, other.small_);
 }
 
 Value::CZString& Value::CZString::operator=(CZString other) {
@@ -196,23 +546,126 @@ Value::CZString& Value::CZString::operator=(CZString other) {
   return *this;
 }
 
+// Interned and static names are often the very same pointer.
 bool Value::CZString::operator<(const CZString& other) const {
-  if (cstr_)
-    return strcmp(cstr_, other.cstr_) < 0;
+  const char* name = c_str();
+  if (name) {
+    const char* otherName = other.c_str();
+    return name != otherName && strcmp(name, otherName) < 0;
+  }
   return index_ < other.index_;
 }
 
 bool Value::CZString::operator==(const CZString& other) const {
-  if (cstr_)
-    return strcmp(cstr_, other.cstr_) == 0;
+  const char* name = c_str();
+  if (name) {
+    const char* otherName = other.c_str();
+    return name == otherName || strcmp(name, otherName) == 0;
+  }
   return index_ == other.index_;
 }
 
 ArrayIndex Value::CZString::index() const { return index_; }
 
-const char* Value::CZString::c_str() const { return cstr_; }
+const char* Value::CZString::c_str() const { return small_ ? chars_ : cstr_; }
+
+bool Value::CZString::isStaticString() const {
+  return !small_ && index_ == noDuplication;
+}
+
+#ifdef JSON_USE_FLAT_MAP
+// FNV-1a for names, a multiplicative hash for indexes.
+unsigned int Value::CZString::hash() const {
+  const char* name = c_str();
+  if (!name)
+    return index_ * 2654435761u;
+  unsigned int hash = 2166136261u;
+  for (; *name; ++name)
+    hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+  return hash;
+}
+#endif
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// Heap containers
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// Arrays and objects not in a resource are allocated and freed through these.
 
-bool Value::CZString::isStaticString() const { return index_ == noDuplication; }
+#if defined(JSON_COPY_ON_WRITE)
+/* Container with the number of Values sharing it. Values only modify a
+ * container they do not share (see Value::unshare()), so it can be read by
+ * all of them, from any thread, while the count is updated atomically.
+ */
+template <typename Container> struct SharedContainer : public Container {
+  SharedContainer() : refs_(1) {}
+  explicit SharedContainer(const Container& other)
+      : Container(other), refs_(1) {}
+
+#if JSON_HAS_STD_THREAD
+  std::atomic<unsigned int> refs_;
+#else
+  unsigned int refs_;
+#endif
+};
+
+template <typename Container>
+static inline SharedContainer<Container>* sharedContainer(Container* container) {
+  return static_cast<SharedContainer<Container>*>(container);
+}
+
+template <typename Container>
+static inline Container* shareContainer(Container* container) {
+  ++sharedContainer(container)->refs_;
+  return container;
+}
+
+template <typename Container>
+static inline bool isSharedContainer(Container* container) {
+  return sharedContainer(container)->refs_ != 1;
+}
+#endif // if defined(JSON_COPY_ON_WRITE)
+
+template <typename Container> static inline Container* newContainer() {
+#if defined(JSON_COPY_ON_WRITE)
+  return new SharedContainer<Container>();
+#else
+  return new Container();
+#endif
+}
+
+template <typename Container>
+static inline void releaseContainer(Container* container) {
+#if defined(JSON_COPY_ON_WRITE)
+  SharedContainer<Container>* shared = sharedContainer(container);
+  if (--shared->refs_ == 0)
+    delete shared;
+#else
+  delete container;
+#endif
+}
+
+static Value::ArrayValues* copyArrayValues(const Value::ArrayValues& other) {
+  Value::ArrayValues* elements = newContainer<Value::ArrayValues>();
+  elements->reserve(other.size());
+  for (Value::ArrayValues::const_iterator it = other.begin();
+       it != other.end();
+       ++it)
+    elements->push_back(*it);
+  return elements;
+}
+
+static Value::ObjectValues* copyObjectValues(const Value::ObjectValues& other) {
+#if defined(JSON_COPY_ON_WRITE)
+  return new SharedContainer<Value::ObjectValues>(other);
+#else
+  return new Value::ObjectValues(other);
+#endif
+}
 
 #endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 
@@ -245,8 +698,10 @@ Value::Value(ValueType type) {
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_ = newContainer<ArrayValues>();
+    break;
   case objectValue:
-    value_.map_ = new ObjectValues();
+    value_.map_ = newContainer<ObjectValues>();
     break;
 #else
   case arrayValue:
@@ -290,20 +745,18 @@ Value::Value(double value) {
 }
 
 Value::Value(const char* value) {
-  initBasic(stringValue, true);
-  value_.string_ = duplicateStringValue(value);
+  initBasic(stringValue);
+  initString(value, (unsigned int)strlen(value));
 }
 
 Value::Value(const char* beginValue, const char* endValue) {
-  initBasic(stringValue, true);
-  value_.string_ =
-      duplicateStringValue(beginValue, (unsigned int)(endValue - beginValue));
+  initBasic(stringValue);
+  initString(beginValue, (unsigned int)(endValue - beginValue));
 }
 
 Value::Value(const std::string& value) {
-  initBasic(stringValue, true);
-  value_.string_ =
-      duplicateStringValue(value.c_str(), (unsigned int)value.length());
+  initBasic(stringValue);
+  initString(value.data(), (unsigned int)value.length());
 }
 
 Value::Value(const StaticString& value) {
@@ -313,8 +766,8 @@ Value::Value(const StaticString& value) {
 
 #ifdef JSON_USE_CPPTL
 Value::Value(const CppTL::ConstString& value) {
-  initBasic(stringValue, true);
-  value_.string_ = duplicateStringValue(value, value.length());
+  initBasic(stringValue);
+  initString(value, value.length());
 }
 #endif
 
@@ -323,14 +776,59 @@ Value::Value(bool value) {
   value_.bool_ = value;
 }
 
+Value::Value(ValueType type, MemoryResource& resource) {
+  initBasic(type);
+  switch (type) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  case arrayValue:
+    value_.array_ = new (resource.allocate(sizeof(ArrayValues)))
+        ArrayValues(ArrayValues::allocator_type(&resource));
+    break;
+  case objectValue:
+    value_.map_ = new (resource.allocate(sizeof(ObjectValues)))
+        ObjectValues(ObjectValues::key_compare(),
+                     ObjectValues::allocator_type(&resource));
+    break;
+#endif
+  default: {
+    // Nothing to allocate.
+    Value value(type);
+    swapPayload(value);
+  } break;
+  }
+}
+
+Value::Value(const char* beginValue,
+             const char* endValue,
+             MemoryResource& resource) {
+  // Short strings are kept inline as usual, which takes no room in the
+  // resource. Strings of a monotonic resource are neither allocated_ nor
+  // fromResource_: they are released with the resource.
+  initBasic(stringValue);
+  size_t length = size_t(endValue - beginValue);
+  if (length < smallStringSize) {
+    initString(beginValue, (unsigned int)length);
+  } else if (resource.isMonotonic()) {
+    value_.string_ = resource.duplicate(beginValue, length);
+  } else {
+    value_.string_ = duplicateResourceString(resource, beginValue, length);
+    fromResource_ = true;
+  }
+}
+
 Value::Value(const Value& other)
-    : type_(other.type_), allocated_(false)
+    : type_(other.type_), allocated_(false), small_(false),
+      fromResource_(false)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
 #endif
       ,
+#if defined(JSON_COMPACT_VALUE)
+      metadata_(0) {
+#else
       comments_(0), start_(other.start_), limit_(other.limit_) {
+#endif
   switch (type_) {
   case nullValue:
   case intValue:
@@ -340,18 +838,48 @@ Value::Value(const Value& other)
     value_ = other.value_;
     break;
   case stringValue:
-    if (other.value_.string_) {
-      value_.string_ = duplicateStringValue(other.value_.string_);
-      allocated_ = true;
+    if (other.small_) {
+      value_ = other.value_;
+      small_ = true;
+    } else if (other.value_.string_) {
+      initString(other.value_.string_,
+                 (unsigned int)strlen(other.value_.string_));
     } else {
       value_.string_ = 0;
-      allocated_ = false;
     }
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+#if defined(JSON_COPY_ON_WRITE)
+    if (!other.value_.array_->get_allocator().resource()) {
+      value_.array_ = shareContainer(other.value_.array_);
+      break;
+    }
+#endif
+    // Always on the heap, even if other is in a resource.
+    value_.array_ = copyArrayValues(*other.value_.array_);
+    break;
   case objectValue:
-    value_.map_ = new ObjectValues(*other.value_.map_);
+    if (other.value_.map_->get_allocator().resource()) {
+      // Rebuild on the heap, with names of our own.
+      value_.map_ = newContainer<ObjectValues>();
+      for (ObjectValues::const_iterator it = other.value_.map_->begin();
+           it != other.value_.map_->end();
+           ++it) {
+        const char* name = it->first.c_str();
+        CZString key = name && it->first.index() == CZString::arenaOwned
+                           ? CZString(name, CZString::duplicateOnCopy)
+                           : it->first;
+        value_.map_->insert(value_.map_->end(),
+                            ObjectValues::value_type(key, it->second));
+      }
+    } else {
+#if defined(JSON_COPY_ON_WRITE)
+      value_.map_ = shareContainer(other.value_.map_);
+#else
+      value_.map_ = copyObjectValues(*other.value_.map_);
+#endif
+    }
     break;
 #else
   case arrayValue:
@@ -364,16 +892,105 @@ Value::Value(const Value& other)
   default:
     JSON_ASSERT_UNREACHABLE;
   }
-  if (other.comments_) {
-    comments_ = new CommentInfo[numberOfCommentPlacement];
+#if defined(JSON_COMPACT_VALUE)
+  const CommentInfo* otherComments = 0;
+  if (const Metadata* otherMetadata = other.findMetadata()) {
+    Metadata& metadata = this->metadata();
+    metadata.start_ = otherMetadata->start_;
+    metadata.limit_ = otherMetadata->limit_;
+    otherComments = otherMetadata->comments_;
+  }
+#else
+  const CommentInfo* otherComments = other.comments_;
+#endif
+  if (otherComments) {
+    CommentInfo* comments = new CommentInfo[numberOfCommentPlacement];
     for (int comment = 0; comment < numberOfCommentPlacement; ++comment) {
-      const CommentInfo& otherComment = other.comments_[comment];
+      const CommentInfo& otherComment = otherComments[comment];
       if (otherComment.comment_)
-        comments_[comment].setComment(
-            otherComment.comment_, strlen(otherComment.comment_));
+        comments[comment].setComment(
+            otherComment.comment_, strlen(otherComment.comment_), 0);
+    }
+#if defined(JSON_COMPACT_VALUE)
+    metadata().comments_ = comments;
+#else
+    comments_ = comments;
+#endif
+  }
+}
+
+#if JSON_HAS_RVALUE_REFERENCES
+Value::Value(Value&& other) {
+  initBasic(nullValue);
+  // swap() copies the whole payload, which a null value leaves unset.
+  memset(&value_, 0, sizeof(value_));
+  swap(other);
+}
+#endif
+
+#if defined(JSON_COPY_ON_WRITE)
+bool Value::isShared() const {
+  switch (type_) {
+  case arrayValue:
+    return !value_.array_->get_allocator().resource() &&
+           isSharedContainer(value_.array_);
+  case objectValue:
+    return !value_.map_->get_allocator().resource() &&
+           isSharedContainer(value_.map_);
+  default:
+    return false;
+  }
+}
+
+void Value::unshare() {
+  if (!isShared())
+    return;
+  if (type_ == arrayValue) {
+    ArrayValues* elements = copyArrayValues(*value_.array_);
+    releaseContainer(value_.array_);
+    value_.array_ = elements;
+  } else {
+    ObjectValues* members = copyObjectValues(*value_.map_);
+    releaseContainer(value_.map_);
+    value_.map_ = members;
+  }
+}
+
+void Value::unshareAll() {
+  unshare();
+  if (type_ == arrayValue) {
+    for (ArrayValues::iterator it = value_.array_->begin();
+         it != value_.array_->end();
+         ++it)
+      it->unshareAll();
+  } else if (type_ == objectValue) {
+    for (ObjectValues::iterator it = value_.map_->begin();
+         it != value_.map_->end();
+         ++it)
+      it->second.unshareAll();
+  }
+}
+
+bool Value::holds(const Value* target) const {
+  if (type_ == arrayValue) {
+    for (ArrayValues::const_iterator it = value_.array_->begin();
+         it != value_.array_->end();
+         ++it) {
+      if (&*it == target || (!it->isShared() && it->holds(target)))
+        return true;
+    }
+  } else if (type_ == objectValue) {
+    for (ObjectValues::const_iterator it = value_.map_->begin();
+         it != value_.map_->end();
+         ++it) {
+      const Value& member = it->second;
+      if (&member == target || (!member.isShared() && member.holds(target)))
+        return true;
     }
   }
+  return false;
 }
+#endif
 
 Value::~Value() {
   switch (type_) {
@@ -386,11 +1003,25 @@ Value::~Value() {
   case stringValue:
     if (allocated_)
       releaseStringValue(value_.string_);
+    else if (fromResource_)
+      releaseResourceString(value_.string_);
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    if (MemoryResource* resource = value_.array_->get_allocator().resource()) {
+      value_.array_->~ArrayValues();
+      resource->deallocate(value_.array_, sizeof(ArrayValues));
+    } else {
+      releaseContainer(value_.array_);
+    }
+    break;
   case objectValue:
-    delete value_.map_;
+    if (MemoryResource* resource = value_.map_->get_allocator().resource()) {
+      value_.map_->~ObjectValues();
+      resource->deallocate(value_.map_, sizeof(ObjectValues));
+    } else {
+      releaseContainer(value_.map_);
+    }
     break;
 #else
   case arrayValue:
@@ -404,11 +1035,26 @@ Value::~Value() {
     JSON_ASSERT_UNREACHABLE;
   }
 
+#if defined(JSON_COMPACT_VALUE)
+  if (metadata_) {
+    MetadataTable& table = MetadataTable::instance();
+    delete[] table[metadata_].comments_;
+    table.remove(metadata_);
+  }
+#else
   if (comments_)
     delete[] comments_;
+#endif
 }
 
 Value& Value::operator=(Value other) {
+#if defined(JSON_COPY_ON_WRITE)
+  // As in `Value& k = o["k"]; k = o;`, this value may be within the
+  // container that other shares: other then gets containers of its own, or
+  // that container would end up holding itself.
+  if (other.isShared() && other.holds(this))
+    other.unshareAll();
+#endif
   swap(other);
   return *this;
 }
@@ -421,13 +1067,23 @@ void Value::swapPayload(Value& other) {
   int temp2 = allocated_;
   allocated_ = other.allocated_;
   other.allocated_ = temp2;
+  temp2 = small_;
+  small_ = other.small_;
+  other.small_ = temp2;
+  temp2 = fromResource_;
+  fromResource_ = other.fromResource_;
+  other.fromResource_ = temp2;
 }
 
 void Value::swap(Value& other) {
   swapPayload(other);
+#if defined(JSON_COMPACT_VALUE)
+  std::swap(metadata_, other.metadata_);
+#else
   std::swap(comments_, other.comments_);
   std::swap(start_, other.start_);
   std::swap(limit_, other.limit_);
+#endif
 }
 
 ValueType Value::type() const { return type_; }
@@ -455,12 +1111,27 @@ bool Value::operator<(const Value& other) const {
     return value_.real_ < other.value_.real_;
   case booleanValue:
     return value_.bool_ < other.value_.bool_;
-  case stringValue:
-    return (value_.string_ == 0 && other.value_.string_) ||
-           (other.value_.string_ && value_.string_ &&
-            strcmp(value_.string_, other.value_.string_) < 0);
+  case stringValue: {
+    const char* string = stringPointer();
+    const char* otherString = other.stringPointer();
+    return (string == 0 && otherString) ||
+           (otherString && string && strcmp(string, otherString) < 0);
+  }
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue:
+  case arrayValue: {
+    int delta = int(value_.array_->size() - other.value_.array_->size());
+    if (delta)
+      return delta < 0;
+    const ArrayValues& elements = *value_.array_;
+    const ArrayValues& otherElements = *other.value_.array_;
+    for (ArrayIndex index = 0; index < elements.size(); ++index) {
+      if (elements[index] < otherElements[index])
+        return true;
+      if (otherElements[index] < elements[index])
+        return false;
+    }
+    return false;
+  }
   case objectValue: {
     int delta = int(value_.map_->size() - other.value_.map_->size());
     if (delta)
@@ -504,12 +1175,24 @@ bool Value::operator==(const Value& other) const {
     return value_.real_ == other.value_.real_;
   case booleanValue:
     return value_.bool_ == other.value_.bool_;
-  case stringValue:
-    return (value_.string_ == other.value_.string_) ||
-           (other.value_.string_ && value_.string_ &&
-            strcmp(value_.string_, other.value_.string_) == 0);
+  case stringValue: {
+    const char* string = stringPointer();
+    const char* otherString = other.stringPointer();
+    return (string == otherString) ||
+           (otherString && string && strcmp(string, otherString) == 0);
+  }
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue:
+  case arrayValue: {
+    const ArrayValues& elements = *value_.array_;
+    const ArrayValues& otherElements = *other.value_.array_;
+    if (elements.size() != otherElements.size())
+      return false;
+    for (ArrayIndex index = 0; index < elements.size(); ++index) {
+      if (!(elements[index] == otherElements[index]))
+        return false;
+    }
+    return true;
+  }
   case objectValue:
     return value_.map_->size() == other.value_.map_->size() &&
            (*value_.map_) == (*other.value_.map_);
@@ -530,7 +1213,7 @@ bool Value::operator!=(const Value& other) const { return !(*this == other); }
 const char* Value::asCString() const {
   JSON_ASSERT_MESSAGE(type_ == stringValue,
                       "in Json::Value::asCString(): requires stringValue");
-  return value_.string_;
+  return stringPointer();
 }
 
 std::string Value::asString() const {
@@ -538,7 +1221,7 @@ std::string Value::asString() const {
   case nullValue:
     return "";
   case stringValue:
-    return value_.string_ ? value_.string_ : "";
+    return stringPointer() ? stringPointer() : "";
   case booleanValue:
     return value_.bool_ ? "true" : "false";
   case intValue:
@@ -731,7 +1414,7 @@ bool Value::isConvertibleTo(ValueType other) const {
     return (isNumeric() && asDouble() == 0.0) ||
            (type_ == booleanValue && value_.bool_ == false) ||
            (type_ == stringValue && asString() == "") ||
-           (type_ == arrayValue && value_.map_->size() == 0) ||
+           (type_ == arrayValue && value_.array_->size() == 0) ||
            (type_ == objectValue && value_.map_->size() == 0) ||
            type_ == nullValue;
   case intValue:
@@ -769,13 +1452,8 @@ ArrayIndex Value::size() const {
   case stringValue:
     return 0;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue: // size of the array is highest index + 1
-    if (!value_.map_->empty()) {
-      ObjectValues::const_iterator itLast = value_.map_->end();
-      --itLast;
-      return (*itLast).first.index() + 1;
-    }
-    return 0;
+  case arrayValue:
+    return ArrayIndex(value_.array_->size());
   case objectValue:
     return ArrayIndex(value_.map_->size());
 #else
@@ -802,11 +1480,14 @@ void Value::clear() {
   JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue ||
                           type_ == objectValue,
                       "in Json::Value::clear(): requires complex value");
-  start_ = 0;
-  limit_ = 0;
+  setOffsetStart(0);
+  setOffsetLimit(0);
+  unshare();
   switch (type_) {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_->clear();
+    break;
   case objectValue:
     value_.map_->clear();
     break;
@@ -828,20 +1509,18 @@ void Value::resize(ArrayIndex newSize) {
                       "in Json::Value::resize(): requires arrayValue");
   if (type_ == nullValue)
     *this = Value(arrayValue);
-#ifndef JSON_VALUE_USE_INTERNAL_MAP
-  ArrayIndex oldSize = size();
-  if (newSize == 0)
-    clear();
-  else if (newSize > oldSize)
-    (*this)[newSize - 1];
-  else {
-    for (ArrayIndex index = newSize; index < oldSize; ++index) {
-      value_.map_->erase(index);
-    }
-    assert(size() == newSize);
-  }
-#else
+  unshare();
   value_.array_->resize(newSize);
+}
+
+void Value::reserve(ArrayIndex newSize) {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
+                      "in Json::Value::reserve(): requires arrayValue");
+  if (type_ == nullValue)
+    *this = Value(arrayValue);
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  unshare();
+  value_.array_->reserve(newSize);
 #endif
 }
 
@@ -852,14 +1531,12 @@ Value& Value::operator[](ArrayIndex index) {
   if (type_ == nullValue)
     *this = Value(arrayValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString key(index);
-  ObjectValues::iterator it = value_.map_->lower_bound(key);
-  if (it != value_.map_->end() && (*it).first == key)
-    return (*it).second;
-
-  ObjectValues::value_type defaultValue(key, null);
-  it = value_.map_->insert(it, defaultValue);
-  return (*it).second;
+  unshare();
+  if (index == value_.array_->size())
+    return value_.array_->append();
+  if (index > value_.array_->size())
+    value_.array_->resize(index + 1);
+  return (*value_.array_)[index];
 #else
   return value_.array_->resolveReference(index);
 #endif
@@ -879,11 +1556,9 @@ const Value& Value::operator[](ArrayIndex index) const {
   if (type_ == nullValue)
     return null;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString key(index);
-  ObjectValues::const_iterator it = value_.map_->find(key);
-  if (it == value_.map_->end())
+  if (index >= value_.array_->size())
     return null;
-  return (*it).second;
+  return (*value_.array_)[index];
 #else
   Value* value = value_.array_->find(index);
   return value ? *value : null;
@@ -904,32 +1579,71 @@ Value& Value::operator[](const char* key) {
 void Value::initBasic(ValueType type, bool allocated) {
   type_ = type;
   allocated_ = allocated;
+  small_ = 0;
+  fromResource_ = 0;
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   itemIsUsed_ = 0;
 #endif
+#if defined(JSON_COMPACT_VALUE)
+  metadata_ = 0;
+#else
   comments_ = 0;
   start_ = 0;
   limit_ = 0;
+#endif
 }
 
-Value& Value::resolveReference(const char* key, bool isStatic) {
+void Value::initString(const char* begin, unsigned int length) {
+  if (length < smallStringSize) {
+    memcpy(value_.chars_, begin, length);
+    value_.chars_[length] = 0;
+    allocated_ = false;
+    small_ = true;
+  } else {
+    value_.string_ = duplicateStringValue(begin, length);
+    allocated_ = true;
+    small_ = false;
+  }
+}
+
+const char* Value::stringPointer() const {
+  return small_ ? value_.chars_ : value_.string_;
+}
+
+Value& Value::resolveReference(const char* key, bool isStatic, bool sorted) {
   JSON_ASSERT_MESSAGE(
       type_ == nullValue || type_ == objectValue,
       "in Json::Value::resolveReference(): requires objectValue");
   if (type_ == nullValue)
     *this = Value(objectValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  unshare();
   CZString actualKey(
       key, isStatic ? CZString::noDuplication : CZString::duplicateOnCopy);
-  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
+  ObjectValues::iterator it = sorted ? value_.map_->lower_bound(actualKey)
+                                     : value_.map_->find(actualKey);
   if (it != value_.map_->end() && (*it).first == actualKey)
     return (*it).second;
 
+  // Objects in a monotonic resource keep their member names in it, unless
+  // they are short enough to be stored inline.
+  MemoryResource* resource = value_.map_->get_allocator().resource();
+  if (resource && resource->isMonotonic() && !isStatic) {
+    size_t length = strlen(key);
+    if (length >= smallStringSize)
+      actualKey =
+          CZString(resource->duplicate(key, length), CZString::arenaOwned);
+  }
   ObjectValues::value_type defaultValue(actualKey, null);
+#if defined(JSON_USE_FLAT_MAP)
+  if (!sorted)
+    return (*value_.map_->push_back(defaultValue)).second;
+#endif
   it = value_.map_->insert(it, defaultValue);
   Value& value = (*it).second;
   return value;
 #else
+  (void)sorted;
   return value_.map_->resolveReference(key, isStatic);
 #endif
 }
@@ -971,6 +1685,21 @@ Value& Value::operator[](const StaticString& key) {
   return resolveReference(key, true);
 }
 
+Value& Value::addMember(const std::string& key) {
+  return resolveReference(key.c_str(), false, false);
+}
+
+Value& Value::addMember(const StaticString& key) {
+  return resolveReference(key, true, false);
+}
+
+void Value::sortMembers() {
+#if defined(JSON_USE_FLAT_MAP)
+  if (type_ == objectValue)
+    value_.map_->sort();
+#endif
+}
+
 #ifdef JSON_USE_CPPTL
 Value& Value::operator[](const CppTL::ConstString& key) {
   return (*this)[key.c_str()];
@@ -981,7 +1710,47 @@ const Value& Value::operator[](const CppTL::ConstString& key) const {
 }
 #endif
 
-Value& Value::append(const Value& value) { return (*this)[size()] = value; }
+Value& Value::append(const Value& value) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
+                      "in Json::Value::append(): requires arrayValue");
+#if defined(JSON_COPY_ON_WRITE)
+  // Copied first: value may be this array, which unshare() replaces, or
+  // hold it (see operator=()).
+  Value copy(value);
+  if (copy.isShared() && copy.holds(this))
+    copy.unshareAll();
+  Value& element = append(nullValue);
+  element.swap(copy);
+  return element;
+#else
+  if (type_ == nullValue)
+    *this = Value(arrayValue);
+  return value_.array_->push_back(value);
+#endif
+#else
+  return (*this)[size()] = value;
+#endif
+}
+
+#if JSON_HAS_RVALUE_REFERENCES
+Value& Value::append(Value&& value) {
+  // Taken first: value may be an element that growing the array moves.
+  Value moved(std::move(value));
+  Value& element = append(nullValue);
+  element.swap(moved);
+  return element;
+}
+#endif
+
+Value& Value::append(ValueType type) {
+  Value& element = (*this)[size()];
+  if (type != nullValue) {
+    Value init(type);
+    element.swapPayload(init);
+  }
+  return element;
+}
 
 Value Value::get(const char* key, const Value& defaultValue) const {
   const Value* value = &((*this)[key]);
@@ -998,11 +1767,16 @@ bool Value::removeMember(const char* key, Value* removed) {
     return false;
   }
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  unshare();
   CZString actualKey(key, CZString::noDuplication);
   ObjectValues::iterator it = value_.map_->find(actualKey);
   if (it == value_.map_->end())
     return false;
-  *removed = it->second;
+  // Members of an object in a resource may use it: they are copied out.
+  if (value_.map_->get_allocator().resource())
+    *removed = it->second;
+  else
+    removed->swap(it->second);
   value_.map_->erase(it);
   return true;
 #else
@@ -1040,22 +1814,16 @@ bool Value::removeIndex(ArrayIndex index, Value* removed) {
   JSON_FAIL_MESSAGE("removeIndex is not implemented for ValueInternalArray.");
   return false;
 #else
-  CZString key(index);
-  ObjectValues::iterator it = value_.map_->find(key);
-  if (it == value_.map_->end()) {
+  if (index >= value_.array_->size())
     return false;
-  }
-  *removed = it->second;
-  ArrayIndex oldSize = size();
-  // shift left all items left, into the place of the "removed"
-  for (ArrayIndex i = index; i < (oldSize - 1); ++i){
-    CZString key(i);
-    (*value_.map_)[key] = (*this)[i + 1];
-  }
-  // erase the last one ("leftover")
-  CZString keyLast(oldSize - 1);
-  ObjectValues::iterator itLast = value_.map_->find(keyLast);
-  value_.map_->erase(itLast);
+  unshare();
+  ArrayValues::iterator it = value_.array_->begin() + index;
+  // Elements of an array in a resource may use it: they are copied out.
+  if (value_.array_->get_allocator().resource())
+    *removed = *it;
+  else
+    removed->swap(*it);
+  value_.array_->erase(it);
   return true;
 #endif
 }
@@ -1229,13 +1997,25 @@ bool Value::isArray() const { return type_ == arrayValue; }
 bool Value::isObject() const { return type_ == objectValue; }
 
 void Value::setComment(const char* comment, size_t len, CommentPlacement placement) {
-  if (!comments_)
-    comments_ = new CommentInfo[numberOfCommentPlacement];
+  setComment(comment, len, placement, 0);
+}
+
+void Value::setComment(const char* comment,
+                       size_t len,
+                       CommentPlacement placement,
+                       MemoryResource* resource) {
+#if defined(JSON_COMPACT_VALUE)
+  CommentInfo*& comments = metadata().comments_;
+#else
+  CommentInfo*& comments = comments_;
+#endif
+  if (!comments)
+    comments = new CommentInfo[numberOfCommentPlacement];
   if ((len > 0) && (comment[len-1] == '\n')) {
     // Always discard trailing newline, to aid indentation.
     len -= 1;
   }
-  comments_[placement].setComment(comment, len);
+  comments[placement].setComment(comment, len, resource);
 }
 
 void Value::setComment(const char* comment, CommentPlacement placement) {
@@ -1246,6 +2026,57 @@ void Value::setComment(const std::string& comment, CommentPlacement placement) {
   setComment(comment.c_str(), comment.length(), placement);
 }
 
+#if defined(JSON_COMPACT_VALUE)
+bool Value::hasComment(CommentPlacement placement) const {
+  const Metadata* metadata = findMetadata();
+  return metadata && metadata->comments_ &&
+         metadata->comments_[placement].comment_ != 0;
+}
+
+std::string Value::getComment(CommentPlacement placement) const {
+  if (hasComment(placement))
+    return findMetadata()->comments_[placement].comment_;
+  return "";
+}
+
+const char* Value::commentText(CommentPlacement placement) const {
+  const Metadata* metadata = findMetadata();
+  return metadata && metadata->comments_
+             ? metadata->comments_[placement].comment_
+             : 0;
+}
+
+// Zero offsets, the default, do not need a record.
+void Value::setOffsetStart(size_t start) {
+  if (start != 0 || metadata_)
+    metadata().start_ = start;
+}
+
+void Value::setOffsetLimit(size_t limit) {
+  if (limit != 0 || metadata_)
+    metadata().limit_ = limit;
+}
+
+size_t Value::getOffsetStart() const {
+  const Metadata* metadata = findMetadata();
+  return metadata ? metadata->start_ : 0;
+}
+
+size_t Value::getOffsetLimit() const {
+  const Metadata* metadata = findMetadata();
+  return metadata ? metadata->limit_ : 0;
+}
+
+Value::Metadata* Value::findMetadata() const {
+  return metadata_ ? &MetadataTable::instance()[metadata_] : 0;
+}
+
+Value::Metadata& Value::metadata() {
+  if (!metadata_)
+    metadata_ = MetadataTable::instance().add();
+  return MetadataTable::instance()[metadata_];
+}
+#else
 bool Value::hasComment(CommentPlacement placement) const {
   return comments_ != 0 && comments_[placement].comment_ != 0;
 }
@@ -1256,6 +2087,10 @@ std::string Value::getComment(CommentPlacement placement) const {
   return "";
 }
 
+const char* Value::commentText(CommentPlacement placement) const {
+  return comments_ != 0 ? comments_[placement].comment_ : 0;
+}
+
 void Value::setOffsetStart(size_t start) { start_ = start; }
 
 void Value::setOffsetLimit(size_t limit) { limit_ = limit; }
@@ -1263,6 +2098,7 @@ void Value::setOffsetLimit(size_t limit) { limit_ = limit; }
 size_t Value::getOffsetStart() const { return start_; }
 
 size_t Value::getOffsetLimit() const { return limit_; }
+#endif // if defined(JSON_COMPACT_VALUE)
 
 std::string Value::toStyledString() const {
   StyledWriter writer;
@@ -1288,6 +2124,9 @@ Value::const_iterator Value::begin() const {
     break;
 #else
   case arrayValue:
+    if (!value_.array_->empty())
+      return const_iterator(value_.array_->begin(), value_.array_->begin());
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->begin());
@@ -1318,6 +2157,9 @@ Value::const_iterator Value::end() const {
     break;
 #else
   case arrayValue:
+    if (!value_.array_->empty())
+      return const_iterator(value_.array_->end(), value_.array_->begin());
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->end());
@@ -1330,6 +2172,7 @@ Value::const_iterator Value::end() const {
 }
 
 Value::iterator Value::begin() {
+  unshare();
   switch (type_) {
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
@@ -1348,6 +2191,9 @@ Value::iterator Value::begin() {
     break;
 #else
   case arrayValue:
+    if (!value_.array_->empty())
+      return iterator(value_.array_->begin(), value_.array_->begin());
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->begin());
@@ -1360,6 +2206,7 @@ Value::iterator Value::begin() {
 }
 
 Value::iterator Value::end() {
+  unshare();
   switch (type_) {
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
@@ -1378,6 +2225,9 @@ Value::iterator Value::end() {
     break;
 #else
   case arrayValue:
+    if (!value_.array_->empty())
+      return iterator(value_.array_->end(), value_.array_->begin());
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->end());
@@ -17,7 +17,7 @@ namespace Json {
 
 ValueIteratorBase::ValueIteratorBase()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-    : current_(), isNull_(true) {
+    : current_(), element_(), elements_(), isNull_(true) {
 }
 #else
     : isArray_(true), isNull_(true) {
@@ -28,7 +28,10 @@ ValueIteratorBase::ValueIteratorBase()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 ValueIteratorBase::ValueIteratorBase(
     const Value::ObjectValues::iterator& current)
-    : current_(current), isNull_(false) {}
+    : current_(current), element_(), elements_(), isNull_(false) {}
+
+ValueIteratorBase::ValueIteratorBase(Value* element, Value* elements)
+    : current_(), element_(element), elements_(elements), isNull_(false) {}
 #else
 ValueIteratorBase::ValueIteratorBase(
     const ValueInternalArray::IteratorState& state)
@@ -45,6 +48,8 @@ ValueIteratorBase::ValueIteratorBase(
 
 Value& ValueIteratorBase::deref() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (elements_)
+    return *element_;
   return current_->second;
 #else
   if (isArray_)
@@ -55,7 +60,10 @@ Value& ValueIteratorBase::deref() const {
 
 void ValueIteratorBase::increment() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  ++current_;
+  if (elements_)
+    ++element_;
+  else
+    ++current_;
 #else
   if (isArray_)
     ValueInternalArray::increment(iterator_.array_);
@@ -65,7 +73,10 @@ void ValueIteratorBase::increment() {
 
 void ValueIteratorBase::decrement() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  --current_;
+  if (elements_)
+    --element_;
+  else
+    --current_;
 #else
   if (isArray_)
     ValueInternalArray::decrement(iterator_.array_);
@@ -76,7 +87,12 @@ void ValueIteratorBase::decrement() {
 ValueIteratorBase::difference_type
 ValueIteratorBase::computeDistance(const SelfType& other) const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-#ifdef JSON_USE_CPPTL_SMALLMAP
+  if (elements_)
+    return difference_type(other.element_ - element_);
+#if defined(JSON_USE_FLAT_MAP)
+  // Same as the loop below: the number of steps from current_ to other.
+  return other.current_ - current_;
+#elif defined(JSON_USE_CPPTL_SMALLMAP)
   return current_ - other.current_;
 #else
   // Iterator for null value are initialized using the default
@@ -113,6 +129,8 @@ bool ValueIteratorBase::isEqual(const SelfType& other) const {
   if (isNull_) {
     return other.isNull_;
   }
+  if (elements_)
+    return element_ == other.element_;
   return current_ == other.current_;
 #else
   if (isArray_)
@@ -124,6 +142,8 @@ bool ValueIteratorBase::isEqual(const SelfType& other) const {
 void ValueIteratorBase::copy(const SelfType& other) {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   current_ = other.current_;
+  element_ = other.element_;
+  elements_ = other.elements_;
   isNull_ = other.isNull_;
 #else
   if (isArray_)
@@ -134,6 +154,8 @@ void ValueIteratorBase::copy(const SelfType& other) {
 
 Value ValueIteratorBase::key() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (elements_)
+    return Value(ArrayIndex(element_ - elements_));
   const Value::CZString czstring = (*current_).first;
   if (czstring.c_str()) {
     if (czstring.isStaticString())
@@ -154,6 +176,8 @@ Value ValueIteratorBase::key() const {
 
 UInt ValueIteratorBase::index() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (elements_)
+    return UInt(element_ - elements_);
   const Value::CZString czstring = (*current_).first;
   if (!czstring.c_str())
     return czstring.index();
@@ -167,6 +191,8 @@ UInt ValueIteratorBase::index() const {
 
 const char* ValueIteratorBase::memberName() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (elements_)
+    return "";
   const char* name = (*current_).first.c_str();
   return name ? name : "";
 #else
@@ -190,6 +216,9 @@ ValueConstIterator::ValueConstIterator() {}
 ValueConstIterator::ValueConstIterator(
     const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
+
+ValueConstIterator::ValueConstIterator(Value* element, Value* elements)
+    : ValueIteratorBase(element, elements) {}
 #else
 ValueConstIterator::ValueConstIterator(
     const ValueInternalArray::IteratorState& state)
@@ -219,6 +248,9 @@ ValueIterator::ValueIterator() {}
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 ValueIterator::ValueIterator(const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
+
+ValueIterator::ValueIterator(Value* element, Value* elements)
+    : ValueIteratorBase(element, elements) {}
 #else
 ValueIterator::ValueIterator(const ValueInternalArray::IteratorState& state)
     : ValueIteratorBase(state) {}
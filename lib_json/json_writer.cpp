@@ -4,10 +4,12 @@
 // See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
 
 #if !defined(JSON_IS_AMALGAMATION)
+#include <json/assertions.h>
 #include <json/writer.h>
 #include "json_tool.h"
+#include "json_dtoa.h"
+#include "json_scanner.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
-#include <iomanip>
 #include <memory>
 #include <sstream>
 #include <utility>
@@ -16,10 +18,9 @@
 #include <stdio.h>
 #include <string.h>
 
-#if defined(_MSC_VER) && _MSC_VER < 1500 // VC++ 8.0 and below
+#if defined(_MSC_VER) && _MSC_VER < 1800 // VC++ 11.0 and below
 #include <float.h>
 #define isfinite _finite
-#define snprintf _snprintf
 #endif
 
 #if defined(_MSC_VER) && _MSC_VER >= 1400 // VC++ 8.0
@@ -40,27 +41,49 @@ typedef std::unique_ptr<StreamWriter> StreamWriterPtr;
 typedef std::auto_ptr<StreamWriter>   StreamWriterPtr;
 #endif
 
-static bool containsControlCharacter(const char* str) {
-  while (*str) {
-    if (isControlCharacter(*(str++)))
-      return true;
-  }
-  return false;
-}
-
-std::string valueToString(LargestInt value) {
-  UIntToStringBuffer buffer;
+/** Writes \a value into \a buffer, backward from its end, like
+ * uintToString().
+ * \return The first character written.
+ */
+static inline char* intToChars(LargestInt value, UIntToStringBuffer& buffer) {
   char* current = buffer + sizeof(buffer);
   bool isNegative = value < 0;
-  if (isNegative)
-    value = -value;
-  uintToString(LargestUInt(value), current);
+  // Negated as unsigned, which is defined for minLargestInt too.
+  uintToString(isNegative ? LargestUInt(0) - LargestUInt(value)
+                          : LargestUInt(value),
+               current);
   if (isNegative)
     *--current = '-';
   assert(current >= buffer);
   return current;
 }
 
+/** Writes \a value into \a buffer, without null terminator.
+ * Infinities are written as numbers too large to be read back as a double,
+ * and NaN as null.
+ * \return The end of the written characters.
+ */
+static inline char* realToChars(double value, char* buffer) {
+  const char* text;
+  if (isfinite(value))
+    return doubleToChars(value, buffer);
+  // IEEE standard states that NaN values will not compare to themselves
+  if (value != value)
+    text = "null";
+  else if (value < 0)
+    text = "-1e+9999";
+  else
+    text = "1e+9999";
+  size_t length = strlen(text);
+  memcpy(buffer, text, length);
+  return buffer + length;
+}
+
+std::string valueToString(LargestInt value) {
+  UIntToStringBuffer buffer;
+  return intToChars(value, buffer);
+}
+
 std::string valueToString(LargestUInt value) {
   UIntToStringBuffer buffer;
   char* current = buffer + sizeof(buffer);
@@ -82,103 +105,83 @@ std::string valueToString(UInt value) {
 #endif // # if defined(JSON_HAS_INT64)
 
 std::string valueToString(double value) {
-  // Allocate a buffer that is more than large enough to store the 16 digits of
-  // precision requested below.
-  char buffer[32];
-  int len = -1;
-
-// Print into the buffer. We need not request the alternative representation
-// that always has a decimal point because JSON doesn't distingish the
-// concepts of reals and integers.
-#if defined(_MSC_VER) && defined(__STDC_SECURE_LIB__) // Use secure version with
-                                                      // visual studio 2005 to
-                                                      // avoid warning.
-#if defined(WINCE)
-  len = _snprintf(buffer, sizeof(buffer), "%.17g", value);
-#else
-  len = sprintf_s(buffer, sizeof(buffer), "%.17g", value);
-#endif
-#else
-  if (isfinite(value)) {
-    len = snprintf(buffer, sizeof(buffer), "%.17g", value);
-  } else {
-    // IEEE standard states that NaN values will not compare to themselves
-    if (value != value) {
-      len = snprintf(buffer, sizeof(buffer), "null");
-    } else if (value < 0) {
-      len = snprintf(buffer, sizeof(buffer), "-1e+9999");
+  // The shortest string that reads back as the same double, whatever the
+  // locale.
+  char buffer[doubleToCharsBufferSize];
+  return std::string(buffer, realToChars(value, buffer));
+}
+
+// Numbers formatted straight into the document, without temporary string.
+static inline void appendNumber(std::string& document, LargestInt value) {
+  UIntToStringBuffer buffer;
+  document += intToChars(value, buffer);
+}
+
+static inline void appendNumber(std::string& document, LargestUInt value) {
+  UIntToStringBuffer buffer;
+  char* current = buffer + sizeof(buffer);
+  uintToString(value, current);
+  document += current;
+}
+
+static inline void appendNumber(std::string& document, double value) {
+  char buffer[doubleToCharsBufferSize];
+  document.append(buffer, realToChars(value, buffer));
+}
+
+std::string valueToString(bool value) { return value ? "true" : "false"; }
+
+// Escape sequences of the characters below 0x20, as written in strings.
+struct ControlEscape {
+  char text[7];
+  unsigned char length;
+};
+
+static const ControlEscape controlEscapes[0x20] = {
+  {"\\u0000", 6}, {"\\u0001", 6}, {"\\u0002", 6}, {"\\u0003", 6},
+  {"\\u0004", 6}, {"\\u0005", 6}, {"\\u0006", 6}, {"\\u0007", 6},
+  {"\\b", 2},     {"\\t", 2},     {"\\n", 2},     {"\\u000B", 6},
+  {"\\f", 2},     {"\\r", 2},     {"\\u000E", 6}, {"\\u000F", 6},
+  {"\\u0010", 6}, {"\\u0011", 6}, {"\\u0012", 6}, {"\\u0013", 6},
+  {"\\u0014", 6}, {"\\u0015", 6}, {"\\u0016", 6}, {"\\u0017", 6},
+  {"\\u0018", 6}, {"\\u0019", 6}, {"\\u001A", 6}, {"\\u001B", 6},
+  {"\\u001C", 6}, {"\\u001D", 6}, {"\\u001E", 6}, {"\\u001F", 6}
+};
+
+/** Appends [\a begin, \a end) to \a document, quoted and escaped. Runs of
+ * characters that need no escape are found by scanEscape() and copied as a
+ * whole.
+ */
+static inline void appendQuoted(std::string& document,
+                                const char* begin,
+                                const char* end) {
+  document += '"';
+  for (;;) {
+    const char* special = scanEscape(begin, end);
+    document.append(begin, special);
+    if (special == end)
+      break;
+    unsigned char c = static_cast<unsigned char>(*special);
+    if (c < 0x20) {
+      document.append(controlEscapes[c].text, controlEscapes[c].length);
     } else {
-      len = snprintf(buffer, sizeof(buffer), "1e+9999");
+      // '"' or '\\'. Even though \/ is considered a legal escape in JSON,
+      // a bare slash is also legal, so it is not escaped.
+      char escape[2] = {'\\', static_cast<char>(c)};
+      document.append(escape, sizeof(escape));
     }
-    // For those, we do not need to call fixNumLoc, but it is fast.
+    begin = special + 1;
   }
-#endif
-  assert(len >= 0);
-  fixNumericLocale(buffer, buffer + len);
-  return buffer;
+  document += '"';
 }
 
-std::string valueToString(bool value) { return value ? "true" : "false"; }
-
 std::string valueToQuotedString(const char* value) {
   if (value == NULL)
     return "";
-  // Not sure how to handle unicode...
-  if (strpbrk(value, "\"\\\b\f\n\r\t") == NULL &&
-      !containsControlCharacter(value))
-    return std::string("\"") + value + "\"";
-  // We have to walk value and escape any special characters.
-  // Appending to std::string is not efficient, but this should be rare.
-  // (Note: forward slashes are *not* rare, but I am not escaping them.)
-  std::string::size_type maxsize =
-      strlen(value) * 2 + 3; // allescaped+quotes+NULL
+  size_t length = strlen(value);
   std::string result;
-  result.reserve(maxsize); // to avoid lots of mallocs
-  result += "\"";
-  for (const char* c = value; *c != 0; ++c) {
-    switch (*c) {
-    case '\"':
-      result += "\\\"";
-      break;
-    case '\\':
-      result += "\\\\";
-      break;
-    case '\b':
-      result += "\\b";
-      break;
-    case '\f':
-      result += "\\f";
-      break;
-    case '\n':
-      result += "\\n";
-      break;
-    case '\r':
-      result += "\\r";
-      break;
-    case '\t':
-      result += "\\t";
-      break;
-    // case '/':
-    // Even though \/ is considered a legal escape in JSON, a bare
-    // slash is also legal, so I see no reason to escape it.
-    // (I hope I am not misunderstanding something.
-    // blep notes: actually escaping \/ may be useful in javascript to avoid </
-    // sequence.
-    // Should add a flag to allow this compatibility mode and prevent this
-    // sequence from occurring.
-    default:
-      if (isControlCharacter(*c)) {
-        std::ostringstream oss;
-        oss << "\\u" << std::hex << std::uppercase << std::setfill('0')
-            << std::setw(4) << static_cast<int>(*c);
-        result += oss.str();
-      } else {
-        result += *c;
-      }
-      break;
-    }
-  }
-  result += "\"";
+  result.reserve(length + 2);
+  appendQuoted(result, value, value + length);
   return result;
 }
 
@@ -186,489 +189,699 @@ std::string valueToQuotedString(const char* value) {
 // //////////////////////////////////////////////////////////////////
 Writer::~Writer() {}
 
-// Class FastWriter
+// Class Formatter
 // //////////////////////////////////////////////////////////////////
 
-FastWriter::FastWriter()
-    : yamlCompatiblityEnabled_(false), dropNullPlaceholders_(false),
-      omitEndingLineFeed_(false) {}
+// Arrays whose single-line form reaches this length are written one element
+// per line.
+static const size_t rightMargin = 74;
 
-void FastWriter::enableYAMLCompatibility() { yamlCompatiblityEnabled_ = true; }
+static inline bool hasCommentForValue(const Value& value) {
+  return value.hasComment(commentBefore) ||
+         value.hasComment(commentAfterOnSameLine) ||
+         value.hasComment(commentAfter);
+}
 
-void FastWriter::dropNullPlaceholders() { dropNullPlaceholders_ = true; }
+Formatter::Formatter(Style style)
+    : style_(style), indentation_(style == styledStyle ? "   " : "\t"),
+      cs_(style == fastStyle ? StreamWriter::CommentStyle::None
+                             : StreamWriter::CommentStyle::All),
+      colonSymbol_(style == fastStyle ? ":" : " : "), nullSymbol_("null"),
+      endingLineFeedSymbol_(style == builtStyle ? "" : "\n"), document_(0),
+      sink_(0), start_(0), depth_(0), flushedLast_(0), indented_(false) {}
 
-void FastWriter::omitEndingLineFeed() { omitEndingLineFeed_ = true; }
+void Formatter::setIndentation(const std::string& indentation) {
+  indentation_ = indentation;
+}
 
-std::string FastWriter::write(const Value& root) {
-  document_ = "";
-  writeValue(root);
-  if (!omitEndingLineFeed_)
-    document_ += "\n";
-  return document_;
+void Formatter::setCommentStyle(StreamWriter::CommentStyle::Enum cs) {
+  cs_ = cs;
 }
 
-void FastWriter::writeValue(const Value& value) {
-  switch (value.type()) {
-  case nullValue:
-    if (!dropNullPlaceholders_)
-      document_ += "null";
-    break;
-  case intValue:
-    document_ += valueToString(value.asLargestInt());
-    break;
-  case uintValue:
-    document_ += valueToString(value.asLargestUInt());
-    break;
-  case realValue:
-    document_ += valueToString(value.asDouble());
-    break;
-  case stringValue:
-    document_ += valueToQuotedString(value.asCString());
-    break;
-  case booleanValue:
-    document_ += valueToString(value.asBool());
-    break;
-  case arrayValue: {
-    document_ += '[';
-    int size = value.size();
-    for (int index = 0; index < size; ++index) {
-      if (index > 0)
-        document_ += ',';
-      writeValue(value[index]);
-    }
-    document_ += ']';
-  } break;
-  case objectValue: {
-    Value::Members members(value.getMemberNames());
-    document_ += '{';
-    for (Value::Members::iterator it = members.begin(); it != members.end();
-         ++it) {
-      const std::string& name = *it;
-      if (it != members.begin())
-        document_ += ',';
-      document_ += valueToQuotedString(name.c_str());
-      document_ += yamlCompatiblityEnabled_ ? ": " : ":";
-      writeValue(value[name]);
-    }
-    document_ += '}';
-  } break;
-  }
+void Formatter::setColonSymbol(const std::string& colonSymbol) {
+  colonSymbol_ = colonSymbol;
 }
 
-// Class StyledWriter
-// //////////////////////////////////////////////////////////////////
+void Formatter::setNullSymbol(const std::string& nullSymbol) {
+  nullSymbol_ = nullSymbol;
+}
 
-StyledWriter::StyledWriter()
-    : rightMargin_(74), indentSize_(3), addChildValues_() {}
+void Formatter::setEndingLineFeedSymbol(
+    const std::string& endingLineFeedSymbol) {
+  endingLineFeedSymbol_ = endingLineFeedSymbol;
+}
 
-std::string StyledWriter::write(const Value& root) {
-  document_ = "";
-  addChildValues_ = false;
-  indentString_ = "";
+void Formatter::write(const Value& root, std::string& document) {
+  document_ = &document;
+  sink_ = 0;
+  start_ = document.size();
+  writeDocument(root);
+  document_ = 0;
+}
+
+void Formatter::write(const Value& root, OutputSink& sink) {
+  if (buffer_.capacity() < flushSize)
+    buffer_.reserve(2 * flushSize);
+  buffer_.clear();
+  document_ = &buffer_;
+  sink_ = &sink;
+  start_ = 0;
+  writeDocument(root);
+  flush();
+  document_ = 0;
+  sink_ = 0; // Forget the sink, for safety.
+}
+
+void Formatter::writeDocument(const Value& root) {
+  depth_ = 0;
+  flushedLast_ = 0;
+  indented_ = true;
   writeCommentBeforeValue(root);
+  if (style_ != styledStyle && !indented_)
+    writeIndent();
+  indented_ = true;
   writeValue(root);
   writeCommentAfterValueOnSameLine(root);
-  document_ += "\n";
-  return document_;
+  *document_ += endingLineFeedSymbol_;
 }
 
-void StyledWriter::writeValue(const Value& value) {
+void Formatter::writeValue(const Value& value) {
+  if (sink_ && buffer_.size() >= flushSize)
+    flush();
+  switch (value.type()) {
+  case arrayValue:
+    if (value.size() == 0)
+      writeLeaf(value);
+    else
+      writeArrayValue(value);
+    break;
+  case objectValue:
+    if (value.size() == 0)
+      writeLeaf(value);
+    else
+      writeObjectValue(value);
+    break;
+  default:
+    writeLeaf(value);
+    break;
+  }
+}
+
+// Values written the same way on one line or many: scalars and empty
+// containers.
+void Formatter::writeLeaf(const Value& value) {
   switch (value.type()) {
   case nullValue:
-    pushValue("null");
+    *document_ += nullSymbol_;
     break;
   case intValue:
-    pushValue(valueToString(value.asLargestInt()));
+    appendNumber(*document_, value.asLargestInt());
     break;
   case uintValue:
-    pushValue(valueToString(value.asLargestUInt()));
+    appendNumber(*document_, value.asLargestUInt());
     break;
   case realValue:
-    pushValue(valueToString(value.asDouble()));
+    appendNumber(*document_, value.asDouble());
     break;
   case stringValue:
-    pushValue(valueToQuotedString(value.asCString()));
+    writeQuoted(value.asCString());
     break;
   case booleanValue:
-    pushValue(valueToString(value.asBool()));
+    *document_ += value.asBool() ? "true" : "false";
     break;
   case arrayValue:
-    writeArrayValue(value);
+    *document_ += "[]";
+    break;
+  case objectValue:
+    *document_ += "{}";
     break;
-  case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
-      pushValue("{}");
-    else {
-      writeWithIndent("{");
-      indent();
-      Value::Members::iterator it = members.begin();
-      for (;;) {
-        const std::string& name = *it;
-        const Value& childValue = value[name];
-        writeCommentBeforeValue(childValue);
-        writeWithIndent(valueToQuotedString(name.c_str()));
-        document_ += " : ";
-        writeValue(childValue);
-        if (++it == members.end()) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        document_ += ',';
-        writeCommentAfterValueOnSameLine(childValue);
-      }
-      unindent();
-      writeWithIndent("}");
-    }
-  } break;
   }
 }
 
-void StyledWriter::writeArrayValue(const Value& value) {
-  unsigned size = value.size();
-  if (size == 0)
-    pushValue("[]");
-  else {
-    bool isArrayMultiLine = isMultineArray(value);
-    if (isArrayMultiLine) {
-      writeWithIndent("[");
-      indent();
-      bool hasChildValue = !childValues_.empty();
-      unsigned index = 0;
-      for (;;) {
-        const Value& childValue = value[index];
-        writeCommentBeforeValue(childValue);
-        if (hasChildValue)
-          writeWithIndent(childValues_[index]);
-        else {
-          writeIndent();
-          writeValue(childValue);
-        }
-        if (++index == size) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        document_ += ',';
-        writeCommentAfterValueOnSameLine(childValue);
-      }
-      unindent();
-      writeWithIndent("]");
-    } else // output on a single line
-    {
-      assert(childValues_.size() == size);
-      document_ += "[ ";
-      for (unsigned index = 0; index < size; ++index) {
-        if (index > 0)
-          document_ += ", ";
-        document_ += childValues_[index];
-      }
-      document_ += " ]";
+void Formatter::writeArrayValue(const Value& value) {
+  ArrayIndex size = value.size();
+  if (style_ == fastStyle) {
+    *document_ += '[';
+    for (ArrayIndex index = 0; index < size; ++index) {
+      if (index > 0)
+        *document_ += ',';
+      writeValue(value[index]);
     }
+    *document_ += ']';
+    return;
   }
+  if (writeSingleLineArray(value))
+    return;
+  writeWithIndent("[");
+  ++depth_;
+  ArrayIndex index = 0;
+  for (;;) {
+    const Value& childValue = value[index];
+    writeCommentBeforeValue(childValue);
+    writeIndentOnce();
+    indented_ = true;
+    writeValue(childValue);
+    indented_ = false;
+    if (++index == size) {
+      writeCommentAfterValueOnSameLine(childValue);
+      break;
+    }
+    *document_ += ',';
+    writeCommentAfterValueOnSameLine(childValue);
+  }
+  --depth_;
+  writeWithIndent("]");
 }
 
-bool StyledWriter::isMultineArray(const Value& value) {
-  int size = value.size();
-  bool isMultiLine = size * 3 >= rightMargin_;
-  childValues_.clear();
-  for (int index = 0; index < size && !isMultiLine; ++index) {
+/* Writes value on a single line if the styled writers would: none of its
+ * elements is a non-empty container or has a comment, and the line, counted
+ * as "[ a, b ]", stays under rightMargin. The elements are written
+ * speculatively, and taken back as soon as the line gets too long.
+ * Nothing is flushed meanwhile, since only leaves are written.
+ * \return false, with nothing written, if value needs several lines.
+ */
+bool Formatter::writeSingleLineArray(const Value& value) {
+  if (style_ == builtStyle && cs_ == StreamWriter::CommentStyle::All)
+    return false;
+  ArrayIndex size = value.size();
+  if (size_t(size) * 3 >= rightMargin)
+    return false;
+  for (ArrayIndex index = 0; index < size; ++index) {
     const Value& childValue = value[index];
-    isMultiLine =
-        isMultiLine || ((childValue.isArray() || childValue.isObject()) &&
-                        childValue.size() > 0);
+    if (((childValue.isArray() || childValue.isObject()) &&
+         childValue.size() > 0) ||
+        hasCommentForValue(childValue))
+      return false;
   }
-  if (!isMultiLine) // check if line length > max line length
-  {
-    childValues_.reserve(size);
-    addChildValues_ = true;
-    int lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
-    for (int index = 0; index < size; ++index) {
-      if (hasCommentForValue(value[index])) {
-        isMultiLine = true;
-      }
-      writeValue(value[index]);
-      lineLength += int(childValues_[index].length());
+  // builtStyle without indentation drops the inner spaces, though not from
+  // lineLength.
+  bool spaced = style_ != builtStyle || !indentation_.empty();
+  size_t lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
+  size_t mark = document_->size();
+  *document_ += spaced ? "[ " : "[";
+  for (ArrayIndex index = 0; index < size; ++index) {
+    if (index > 0)
+      *document_ += ", ";
+    size_t before = document_->size();
+    writeLeaf(value[index]);
+    lineLength += document_->size() - before;
+    if (lineLength >= rightMargin) {
+      document_->resize(mark);
+      return false;
     }
-    addChildValues_ = false;
-    isMultiLine = isMultiLine || lineLength >= rightMargin_;
   }
-  return isMultiLine;
+  *document_ += spaced ? " ]" : "]";
+  return true;
 }
 
-void StyledWriter::pushValue(const std::string& value) {
-  if (addChildValues_)
-    childValues_.push_back(value);
-  else
-    document_ += value;
+void Formatter::writeObjectValue(const Value& value) {
+  Value::const_iterator it = value.begin();
+  Value::const_iterator itEnd = value.end();
+  if (style_ == fastStyle) {
+    *document_ += '{';
+    for (bool first = true; it != itEnd; ++it, first = false) {
+      if (!first)
+        *document_ += ',';
+      writeQuoted(it.memberName());
+      *document_ += colonSymbol_;
+      writeValue(*it);
+    }
+    *document_ += '}';
+    return;
+  }
+  writeWithIndent("{");
+  ++depth_;
+  for (;;) {
+    const Value& childValue = *it;
+    writeCommentBeforeValue(childValue);
+    writeIndentOnce();
+    writeQuoted(it.memberName());
+    indented_ = false;
+    *document_ += colonSymbol_;
+    writeValue(childValue);
+    if (++it == itEnd) {
+      writeCommentAfterValueOnSameLine(childValue);
+      break;
+    }
+    *document_ += ',';
+    writeCommentAfterValueOnSameLine(childValue);
+  }
+  --depth_;
+  writeWithIndent("}");
+}
+
+void Formatter::writeQuoted(const char* value) {
+  if (value != NULL)
+    appendQuoted(*document_, value, value + strlen(value));
 }
 
-void StyledWriter::writeIndent() {
-  if (!document_.empty()) {
-    char last = document_[document_.length() - 1];
+// The styled writers look at the last character of the document to know
+// whether they are indented; the stream writers track it in indented_,
+// which callers check.
+void Formatter::writeIndent() {
+  if (style_ == styledStyle) {
+    char last = lastChar();
     if (last == ' ') // already indented
       return;
-    if (last != '\n') // Comments may add new-line
-      document_ += '\n';
+    if (last != 0 && last != '\n') // Comments may add new-line
+      *document_ += '\n';
+  } else if (style_ == builtStyle && indentation_.empty()) {
+    // In this case, drop newlines too.
+    return;
+  } else {
+    *document_ += '\n';
   }
-  document_ += indentString_;
+  for (unsigned int level = 0; level < depth_; ++level)
+    *document_ += indentation_;
 }
 
-void StyledWriter::writeWithIndent(const std::string& value) {
-  writeIndent();
-  document_ += value;
+void Formatter::writeIndentOnce() {
+  if (style_ == styledStyle || !indented_)
+    writeIndent();
 }
 
-void StyledWriter::indent() { indentString_ += std::string(indentSize_, ' '); }
-
-void StyledWriter::unindent() {
-  assert(int(indentString_.size()) >= indentSize_);
-  indentString_.resize(indentString_.size() - indentSize_);
+void Formatter::writeWithIndent(const char* text) {
+  writeIndentOnce();
+  *document_ += text;
+  indented_ = false;
 }
 
-void StyledWriter::writeCommentBeforeValue(const Value& root) {
-  if (!root.hasComment(commentBefore))
+void Formatter::writeCommentBeforeValue(const Value& root) {
+  if (cs_ == StreamWriter::CommentStyle::None)
+    return;
+  const char* comment = root.commentText(commentBefore);
+  if (!comment)
     return;
 
-  document_ += "\n";
-  writeIndent();
-  const std::string& comment = root.getComment(commentBefore);
-  std::string::const_iterator iter = comment.begin();
-  while (iter != comment.end()) {
-    document_ += *iter;
-    if (*iter == '\n' &&
-       (iter != comment.end() && *(iter + 1) == '/'))
+  if (style_ == styledStyle) {
+    *document_ += '\n';
+    writeIndent();
+  } else if (!indented_) {
+    writeIndent();
+  }
+  for (const char* c = comment; *c != 0; ++c) {
+    *document_ += *c;
+    if (*c == '\n' && c[1] == '/') {
+      if (style_ == styledStyle) {
+        writeIndent();
+      } else {
+        // writeIndent() would write an extra newline
+        for (unsigned int level = 0; level < depth_; ++level)
+          *document_ += indentation_;
+      }
+    }
+  }
+  if (style_ == styledStyle) {
+    // Comments are stripped of trailing newlines, so add one here
+    *document_ += '\n';
+  }
+  indented_ = false;
+}
+
+void Formatter::writeCommentAfterValueOnSameLine(const Value& root) {
+  if (cs_ == StreamWriter::CommentStyle::None)
+    return;
+  if (const char* comment = root.commentText(commentAfterOnSameLine)) {
+    *document_ += ' ';
+    *document_ += comment;
+  }
+  if (const char* comment = root.commentText(commentAfter)) {
+    if (style_ == styledStyle) {
+      *document_ += '\n';
+      *document_ += comment;
+      *document_ += '\n';
+    } else {
       writeIndent();
-    ++iter;
+      *document_ += comment;
+    }
   }
+  if (style_ == styledStreamStyle)
+    indented_ = false;
+}
 
-  // Comments are stripped of trailing newlines, so add one here
-  document_ += "\n";
+// Last character written, 0 at the start of the document.
+char Formatter::lastChar() const {
+  if (document_->size() > start_)
+    return (*document_)[document_->size() - 1];
+  return flushedLast_;
 }
 
-void StyledWriter::writeCommentAfterValueOnSameLine(const Value& root) {
-  if (root.hasComment(commentAfterOnSameLine))
-    document_ += " " + root.getComment(commentAfterOnSameLine);
+void Formatter::flush() {
+  if (!sink_ || buffer_.empty())
+    return;
+  flushedLast_ = buffer_[buffer_.size() - 1];
+  sink_->write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+}
 
-  if (root.hasComment(commentAfter)) {
-    document_ += "\n";
-    document_ += root.getComment(commentAfter);
-    document_ += "\n";
-  }
+// Class StreamingWriter
+// //////////////////////////////////////////////////////////////////
+
+StreamingWriter::StreamingWriter(OutputSink& sink, Style style)
+    : sink_(sink), style_(style), indentation_("   "), singleLineStart_(0),
+      documentStart_(0), depth_(0), flushedLast_(0), pending_(false),
+      singleLine_(false), afterKey_(false) {
+  buffer_.reserve(2 * Formatter::flushSize);
 }
 
-bool StyledWriter::hasCommentForValue(const Value& value) {
-  return value.hasComment(commentBefore) ||
-         value.hasComment(commentAfterOnSameLine) ||
-         value.hasComment(commentAfter);
+StreamingWriter::~StreamingWriter() {
+  // An unfinished array goes out as it is.
+  singleLine_ = false;
+  flush();
 }
 
-// Class StyledStreamWriter
-// //////////////////////////////////////////////////////////////////
+void StreamingWriter::setIndentation(const std::string& indentation) {
+  indentation_ = indentation;
+}
 
-StyledStreamWriter::StyledStreamWriter(std::string indentation)
-    : document_(NULL), rightMargin_(74), indentation_(indentation),
-      addChildValues_() {}
+void StreamingWriter::beginObject() { beginContainer(true); }
 
-void StyledStreamWriter::write(std::ostream& out, const Value& root) {
-  document_ = &out;
-  addChildValues_ = false;
-  indentString_ = "";
-  indented_ = true;
-  writeCommentBeforeValue(root);
-  if (!indented_) writeIndent();
-  indented_ = true;
-  writeValue(root);
-  writeCommentAfterValueOnSameLine(root);
-  *document_ << "\n";
-  document_ = NULL; // Forget the stream, for safety.
+void StreamingWriter::endObject() { endContainer(true); }
+
+void StreamingWriter::beginArray() { beginContainer(false); }
+
+void StreamingWriter::endArray() { endContainer(false); }
+
+void StreamingWriter::key(const char* name) { key(name, name + strlen(name)); }
+
+void StreamingWriter::key(const std::string& name) {
+  key(name.data(), name.data() + name.length());
+}
+
+void StreamingWriter::key(const char* begin, const char* end) {
+  JSON_ASSERT_MESSAGE(!frames_.empty() && frames_.back().isObject_ &&
+                          !afterKey_,
+                      "in Json::StreamingWriter::key(): not expecting a key");
+  openPending();
+  Frame& frame = frames_.back();
+  if (frame.count_ > 0)
+    buffer_ += ',';
+  if (style_ == styledStyle)
+    writeIndent();
+  appendQuoted(buffer_, begin, end);
+  buffer_ += style_ == styledStyle ? " : " : ":";
+  ++frame.count_;
+  afterKey_ = true;
+}
+
+void StreamingWriter::null() {
+  openPending();
+  placeValue();
+  buffer_ += "null";
+  valueDone();
+}
+
+void StreamingWriter::value(bool value) {
+  openPending();
+  placeValue();
+  buffer_ += value ? "true" : "false";
+  valueDone();
+}
+
+void StreamingWriter::value(Int value) { writeNumber(LargestInt(value)); }
+
+void StreamingWriter::value(UInt value) { writeNumber(LargestUInt(value)); }
+
+#if defined(JSON_HAS_INT64)
+
+void StreamingWriter::value(Int64 value) { writeNumber(LargestInt(value)); }
+
+void StreamingWriter::value(UInt64 value) { writeNumber(LargestUInt(value)); }
+
+#endif // if defined(JSON_HAS_INT64)
+
+void StreamingWriter::value(double value) {
+  openPending();
+  placeValue();
+  appendNumber(buffer_, value);
+  valueDone();
 }
 
-void StyledStreamWriter::writeValue(const Value& value) {
+void StreamingWriter::value(const char* value) {
+  this->value(value, value + strlen(value));
+}
+
+void StreamingWriter::value(const std::string& value) {
+  this->value(value.data(), value.data() + value.length());
+}
+
+void StreamingWriter::value(const char* begin, const char* end) {
+  openPending();
+  placeValue();
+  appendQuoted(buffer_, begin, end);
+  valueDone();
+}
+
+void StreamingWriter::value(const Value& value) {
   switch (value.type()) {
   case nullValue:
-    pushValue("null");
+    null();
     break;
   case intValue:
-    pushValue(valueToString(value.asLargestInt()));
+    writeNumber(value.asLargestInt());
     break;
   case uintValue:
-    pushValue(valueToString(value.asLargestUInt()));
+    writeNumber(value.asLargestUInt());
     break;
   case realValue:
-    pushValue(valueToString(value.asDouble()));
+    this->value(value.asDouble());
     break;
   case stringValue:
-    pushValue(valueToQuotedString(value.asCString()));
+    this->value(value.asCString());
     break;
   case booleanValue:
-    pushValue(valueToString(value.asBool()));
-    break;
-  case arrayValue:
-    writeArrayValue(value);
+    this->value(value.asBool());
     break;
+  case arrayValue: {
+    beginArray();
+    ArrayIndex size = value.size();
+    for (ArrayIndex index = 0; index < size; ++index)
+      this->value(value[index]);
+    endArray();
+  } break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
-      pushValue("{}");
-    else {
-      writeWithIndent("{");
-      indent();
-      Value::Members::iterator it = members.begin();
-      for (;;) {
-        const std::string& name = *it;
-        const Value& childValue = value[name];
-        writeCommentBeforeValue(childValue);
-        writeWithIndent(valueToQuotedString(name.c_str()));
-        *document_ << " : ";
-        writeValue(childValue);
-        if (++it == members.end()) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        *document_ << ",";
-        writeCommentAfterValueOnSameLine(childValue);
-      }
-      unindent();
-      writeWithIndent("}");
+    beginObject();
+    Value::const_iterator itEnd = value.end();
+    for (Value::const_iterator it = value.begin(); it != itEnd; ++it) {
+      key(it.memberName());
+      this->value(*it);
     }
+    endObject();
   } break;
   }
 }
 
-void StyledStreamWriter::writeArrayValue(const Value& value) {
-  unsigned size = value.size();
-  if (size == 0)
-    pushValue("[]");
-  else {
-    bool isArrayMultiLine = isMultineArray(value);
-    if (isArrayMultiLine) {
-      writeWithIndent("[");
-      indent();
-      bool hasChildValue = !childValues_.empty();
-      unsigned index = 0;
-      for (;;) {
-        const Value& childValue = value[index];
-        writeCommentBeforeValue(childValue);
-        if (hasChildValue)
-          writeWithIndent(childValues_[index]);
-        else {
-          if (!indented_) writeIndent();
-          indented_ = true;
-          writeValue(childValue);
-          indented_ = false;
-        }
-        if (++index == size) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        *document_ << ",";
-        writeCommentAfterValueOnSameLine(childValue);
-      }
-      unindent();
-      writeWithIndent("]");
-    } else // output on a single line
-    {
-      assert(childValues_.size() == size);
-      *document_ << "[ ";
-      for (unsigned index = 0; index < size; ++index) {
-        if (index > 0)
-          *document_ << ", ";
-        *document_ << childValues_[index];
-      }
-      *document_ << " ]";
-    }
+void StreamingWriter::flush() {
+  // The single-line array may still have to be written again.
+  size_t limit = singleLine_ ? singleLineStart_ : buffer_.size();
+  if (limit == 0)
+    return;
+  if (limit > documentStart_) {
+    flushedLast_ = buffer_[limit - 1];
+    documentStart_ = 0;
+  } else {
+    documentStart_ -= limit;
   }
+  sink_.write(buffer_.data(), limit);
+  buffer_.erase(0, limit);
+  singleLineStart_ -= singleLine_ ? limit : 0;
 }
 
-bool StyledStreamWriter::isMultineArray(const Value& value) {
-  int size = value.size();
-  bool isMultiLine = size * 3 >= rightMargin_;
-  childValues_.clear();
-  for (int index = 0; index < size && !isMultiLine; ++index) {
-    const Value& childValue = value[index];
-    isMultiLine =
-        isMultiLine || ((childValue.isArray() || childValue.isObject()) &&
-                        childValue.size() > 0);
+void StreamingWriter::beginContainer(bool isObject) {
+  openPending();
+  placeValue();
+  Frame frame = {isObject, 0};
+  frames_.push_back(frame);
+  pending_ = true;
+}
+
+void StreamingWriter::endContainer(bool isObject) {
+  JSON_ASSERT_MESSAGE(!frames_.empty() && frames_.back().isObject_ == isObject,
+                      "in Json::StreamingWriter: end of object or array "
+                      "without matching begin");
+  JSON_ASSERT_MESSAGE(!afterKey_,
+                      "in Json::StreamingWriter::endObject(): missing value");
+  if (pending_) {
+    // Empty containers are written like any other leaf.
+    buffer_ += isObject ? "{}" : "[]";
+    pending_ = false;
+  } else if (style_ == compactStyle) {
+    buffer_ += isObject ? '}' : ']';
+  } else if (singleLine_) {
+    buffer_ += " ]";
+    singleLine_ = false;
+  } else {
+    --depth_;
+    writeWithIndent(isObject ? '}' : ']');
   }
-  if (!isMultiLine) // check if line length > max line length
-  {
-    childValues_.reserve(size);
-    addChildValues_ = true;
-    int lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
-    for (int index = 0; index < size; ++index) {
-      if (hasCommentForValue(value[index])) {
-        isMultiLine = true;
-      }
-      writeValue(value[index]);
-      lineLength += int(childValues_[index].length());
-    }
-    addChildValues_ = false;
-    isMultiLine = isMultiLine || lineLength >= rightMargin_;
+  frames_.pop_back();
+  valueDone();
+}
+
+// Writes the opening of the last container begun, now that it is known not
+// to be empty.
+void StreamingWriter::openPending() {
+  if (!pending_)
+    return;
+  pending_ = false;
+  const Frame& frame = frames_.back();
+  if (style_ == compactStyle) {
+    buffer_ += frame.isObject_ ? '{' : '[';
+    return;
+  }
+  // A non-empty container does not fit in a single-line array.
+  if (singleLine_)
+    breakSingleLine(frames_[frames_.size() - 2]);
+  if (frame.isObject_) {
+    writeWithIndent('{');
+    ++depth_;
+  } else {
+    singleLine_ = true;
+    singleLineStart_ = buffer_.size();
+    buffer_ += "[ ";
   }
-  return isMultiLine;
 }
 
-void StyledStreamWriter::pushValue(const std::string& value) {
-  if (addChildValues_)
-    childValues_.push_back(value);
-  else
-    *document_ << value;
+// Writes what goes before a value: its separator, indentation, or nothing
+// after a key.
+void StreamingWriter::placeValue() {
+  if (buffer_.size() >= Formatter::flushSize)
+    flush();
+  if (frames_.empty()) {
+    documentStart_ = buffer_.size();
+    flushedLast_ = 0;
+    depth_ = 0;
+    return;
+  }
+  Frame& frame = frames_.back();
+  if (frame.isObject_) {
+    JSON_ASSERT_MESSAGE(afterKey_,
+                        "in Json::StreamingWriter: member value without key");
+    afterKey_ = false;
+    return;
+  }
+  if (singleLine_ && frame.count_ == maxSingleLineElements)
+    breakSingleLine(frame);
+  if (singleLine_) {
+    if (frame.count_ > 0)
+      buffer_ += ", ";
+    elementStarts_[frame.count_] = buffer_.size() - singleLineStart_ - 2;
+  } else {
+    if (frame.count_ > 0)
+      buffer_ += ',';
+    if (style_ == styledStyle)
+      writeIndent();
+  }
+  ++frame.count_;
 }
 
-void StyledStreamWriter::writeIndent() {
-  // blep intended this to look at the so-far-written string
-  // to determine whether we are already indented, but
-  // with a stream we cannot do that. So we rely on some saved state.
-  // The caller checks indented_.
-  *document_ << '\n' << indentString_;
+// Called once a value is complete.
+void StreamingWriter::valueDone() {
+  if (frames_.empty()) {
+    buffer_ += '\n';
+  } else if (singleLine_ &&
+             buffer_.size() - singleLineStart_ + 2 >= rightMargin) {
+    // The line, counted with its closing " ]", no longer fits.
+    breakSingleLine(frames_.back());
+  }
 }
 
-void StyledStreamWriter::writeWithIndent(const std::string& value) {
-  if (!indented_) writeIndent();
-  *document_ << value;
-  indented_ = false;
+// Writes the elements of the single-line array again, one per line.
+void StreamingWriter::breakSingleLine(const Frame& frame) {
+  singleLine_ = false;
+  scratch_.assign(buffer_, singleLineStart_ + 2, std::string::npos);
+  buffer_.resize(singleLineStart_);
+  writeWithIndent('[');
+  ++depth_;
+  for (ArrayIndex index = 0; index < frame.count_; ++index) {
+    size_t begin = elementStarts_[index];
+    size_t end = index + 1 < frame.count_ ? elementStarts_[index + 1] - 2
+                                          : scratch_.size();
+    if (index > 0)
+      buffer_ += ',';
+    writeIndent();
+    buffer_.append(scratch_, begin, end - begin);
+  }
+}
+
+// Same rule as Formatter::writeIndent() for styledStyle.
+void StreamingWriter::writeIndent() {
+  char last = lastChar();
+  if (last == ' ') // already indented
+    return;
+  if (last != 0 && last != '\n')
+    buffer_ += '\n';
+  for (unsigned int level = 0; level < depth_; ++level)
+    buffer_ += indentation_;
 }
 
-void StyledStreamWriter::indent() { indentString_ += indentation_; }
+void StreamingWriter::writeWithIndent(char text) {
+  writeIndent();
+  buffer_ += text;
+}
 
-void StyledStreamWriter::unindent() {
-  assert(indentString_.size() >= indentation_.size());
-  indentString_.resize(indentString_.size() - indentation_.size());
+// Last character of the current top-level value, 0 at its start.
+char StreamingWriter::lastChar() const {
+  if (buffer_.size() > documentStart_)
+    return buffer_[buffer_.size() - 1];
+  return flushedLast_;
 }
 
-void StyledStreamWriter::writeCommentBeforeValue(const Value& root) {
-  if (!root.hasComment(commentBefore))
-    return;
+void StreamingWriter::writeNumber(LargestInt value) {
+  openPending();
+  placeValue();
+  appendNumber(buffer_, value);
+  valueDone();
+}
 
-  if (!indented_) writeIndent();
-  const std::string& comment = root.getComment(commentBefore);
-  std::string::const_iterator iter = comment.begin();
-  while (iter != comment.end()) {
-    *document_ << *iter;
-    if (*iter == '\n' &&
-       (iter != comment.end() && *(iter + 1) == '/'))
-      // writeIndent();  // would include newline
-      *document_ << indentString_;
-    ++iter;
-  }
-  indented_ = false;
+void StreamingWriter::writeNumber(LargestUInt value) {
+  openPending();
+  placeValue();
+  appendNumber(buffer_, value);
+  valueDone();
 }
 
-void StyledStreamWriter::writeCommentAfterValueOnSameLine(const Value& root) {
-  if (root.hasComment(commentAfterOnSameLine))
-    *document_ << ' ' << root.getComment(commentAfterOnSameLine);
+// Class FastWriter
+// //////////////////////////////////////////////////////////////////
 
-  if (root.hasComment(commentAfter)) {
-    writeIndent();
-    *document_ << root.getComment(commentAfter);
-  }
-  indented_ = false;
+FastWriter::FastWriter() : formatter_(Formatter::fastStyle) {}
+
+void FastWriter::enableYAMLCompatibility() { formatter_.setColonSymbol(": "); }
+
+void FastWriter::dropNullPlaceholders() { formatter_.setNullSymbol(""); }
+
+void FastWriter::omitEndingLineFeed() {
+  formatter_.setEndingLineFeedSymbol("");
 }
 
-bool StyledStreamWriter::hasCommentForValue(const Value& value) {
-  return value.hasComment(commentBefore) ||
-         value.hasComment(commentAfterOnSameLine) ||
-         value.hasComment(commentAfter);
+std::string FastWriter::write(const Value& root) {
+  std::string document;
+  formatter_.write(root, document);
+  return document;
+}
+
+// Class StyledWriter
+// //////////////////////////////////////////////////////////////////
+
+StyledWriter::StyledWriter() : formatter_(Formatter::styledStyle) {}
+
+std::string StyledWriter::write(const Value& root) {
+  std::string document;
+  formatter_.write(root, document);
+  return document;
+}
+
+// Class StyledStreamWriter
+// //////////////////////////////////////////////////////////////////
+
+StyledStreamWriter::StyledStreamWriter(std::string indentation)
+    : formatter_(Formatter::styledStreamStyle) {
+  formatter_.setIndentation(indentation);
+}
+
+void StyledStreamWriter::write(std::ostream& out, const Value& root) {
+  StreamSink sink(out);
+  formatter_.write(root, sink);
 }
 
 //////////////////////////
@@ -685,30 +898,7 @@ struct BuiltStyledStreamWriter : public StreamWriter
       std::string const& endingLineFeedSymbol);
   virtual int write(Value const& root);
 private:
-  void writeValue(Value const& value);
-  void writeArrayValue(Value const& value);
-  bool isMultineArray(Value const& value);
-  void pushValue(std::string const& value);
-  void writeIndent();
-  void writeWithIndent(std::string const& value);
-  void indent();
-  void unindent();
-  void writeCommentBeforeValue(Value const& root);
-  void writeCommentAfterValueOnSameLine(Value const& root);
-  static bool hasCommentForValue(const Value& value);
-
-  typedef std::vector<std::string> ChildValues;
-
-  ChildValues childValues_;
-  std::string indentString_;
-  int rightMargin_;
-  std::string indentation_;
-  CommentStyle::Enum cs_;
-  std::string colonSymbol_;
-  std::string nullSymbol_;
-  std::string endingLineFeedSymbol_;
-  bool addChildValues_ : 1;
-  bool indented_ : 1;
+  Formatter formatter_;
 };
 BuiltStyledStreamWriter::BuiltStyledStreamWriter(
       std::ostream* sout,
@@ -718,224 +908,20 @@ BuiltStyledStreamWriter::BuiltStyledStreamWriter(
       std::string const& nullSymbol,
       std::string const& endingLineFeedSymbol)
   : StreamWriter(sout)
-  , rightMargin_(74)
-  , indentation_(indentation)
-  , cs_(cs)
-  , colonSymbol_(colonSymbol)
-  , nullSymbol_(nullSymbol)
-  , endingLineFeedSymbol_(endingLineFeedSymbol)
-  , addChildValues_(false)
-  , indented_(false)
+  , formatter_(Formatter::builtStyle)
 {
+  formatter_.setIndentation(indentation);
+  formatter_.setCommentStyle(cs);
+  formatter_.setColonSymbol(colonSymbol);
+  formatter_.setNullSymbol(nullSymbol);
+  formatter_.setEndingLineFeedSymbol(endingLineFeedSymbol);
 }
 int BuiltStyledStreamWriter::write(Value const& root)
 {
-  addChildValues_ = false;
-  indented_ = true;
-  indentString_ = "";
-  writeCommentBeforeValue(root);
-  if (!indented_) writeIndent();
-  indented_ = true;
-  writeValue(root);
-  writeCommentAfterValueOnSameLine(root);
-  sout_ << endingLineFeedSymbol_;
+  StreamSink sink(sout_);
+  formatter_.write(root, sink);
   return 0;
 }
-void BuiltStyledStreamWriter::writeValue(Value const& value) {
-  switch (value.type()) {
-  case nullValue:
-    pushValue(nullSymbol_);
-    break;
-  case intValue:
-    pushValue(valueToString(value.asLargestInt()));
-    break;
-  case uintValue:
-    pushValue(valueToString(value.asLargestUInt()));
-    break;
-  case realValue:
-    pushValue(valueToString(value.asDouble()));
-    break;
-  case stringValue:
-    pushValue(valueToQuotedString(value.asCString()));
-    break;
-  case booleanValue:
-    pushValue(valueToString(value.asBool()));
-    break;
-  case arrayValue:
-    writeArrayValue(value);
-    break;
-  case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
-      pushValue("{}");
-    else {
-      writeWithIndent("{");
-      indent();
-      Value::Members::iterator it = members.begin();
-      for (;;) {
-        std::string const& name = *it;
-        Value const& childValue = value[name];
-        writeCommentBeforeValue(childValue);
-        writeWithIndent(valueToQuotedString(name.c_str()));
-        sout_ << colonSymbol_;
-        writeValue(childValue);
-        if (++it == members.end()) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        sout_ << ",";
-        writeCommentAfterValueOnSameLine(childValue);
-      }
-      unindent();
-      writeWithIndent("}");
-    }
-  } break;
-  }
-}
-
-void BuiltStyledStreamWriter::writeArrayValue(Value const& value) {
-  unsigned size = value.size();
-  if (size == 0)
-    pushValue("[]");
-  else {
-    bool isMultiLine = (cs_ == CommentStyle::All) || isMultineArray(value);
-    if (isMultiLine) {
-      writeWithIndent("[");
-      indent();
-      bool hasChildValue = !childValues_.empty();
-      unsigned index = 0;
-      for (;;) {
-        Value const& childValue = value[index];
-        writeCommentBeforeValue(childValue);
-        if (hasChildValue)
-          writeWithIndent(childValues_[index]);
-        else {
-          if (!indented_) writeIndent();
-          indented_ = true;
-          writeValue(childValue);
-          indented_ = false;
-        }
-        if (++index == size) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        sout_ << ",";
-        writeCommentAfterValueOnSameLine(childValue);
-      }
-      unindent();
-      writeWithIndent("]");
-    } else // output on a single line
-    {
-      assert(childValues_.size() == size);
-      sout_ << "[";
-      if (!indentation_.empty()) sout_ << " ";
-      for (unsigned index = 0; index < size; ++index) {
-        if (index > 0)
-          sout_ << ", ";
-        sout_ << childValues_[index];
-      }
-      if (!indentation_.empty()) sout_ << " ";
-      sout_ << "]";
-    }
-  }
-}
-
-bool BuiltStyledStreamWriter::isMultineArray(Value const& value) {
-  int size = value.size();
-  bool isMultiLine = size * 3 >= rightMargin_;
-  childValues_.clear();
-  for (int index = 0; index < size && !isMultiLine; ++index) {
-    Value const& childValue = value[index];
-    isMultiLine =
-        isMultiLine || ((childValue.isArray() || childValue.isObject()) &&
-                        childValue.size() > 0);
-  }
-  if (!isMultiLine) // check if line length > max line length
-  {
-    childValues_.reserve(size);
-    addChildValues_ = true;
-    int lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
-    for (int index = 0; index < size; ++index) {
-      if (hasCommentForValue(value[index])) {
-        isMultiLine = true;
-      }
-      writeValue(value[index]);
-      lineLength += int(childValues_[index].length());
-    }
-    addChildValues_ = false;
-    isMultiLine = isMultiLine || lineLength >= rightMargin_;
-  }
-  return isMultiLine;
-}
-
-void BuiltStyledStreamWriter::pushValue(std::string const& value) {
-  if (addChildValues_)
-    childValues_.push_back(value);
-  else
-    sout_ << value;
-}
-
-void BuiltStyledStreamWriter::writeIndent() {
-  // blep intended this to look at the so-far-written string
-  // to determine whether we are already indented, but
-  // with a stream we cannot do that. So we rely on some saved state.
-  // The caller checks indented_.
-
-  if (!indentation_.empty()) {
-    // In this case, drop newlines too.
-    sout_ << '\n' << indentString_;
-  }
-}
-
-void BuiltStyledStreamWriter::writeWithIndent(std::string const& value) {
-  if (!indented_) writeIndent();
-  sout_ << value;
-  indented_ = false;
-}
-
-void BuiltStyledStreamWriter::indent() { indentString_ += indentation_; }
-
-void BuiltStyledStreamWriter::unindent() {
-  assert(indentString_.size() >= indentation_.size());
-  indentString_.resize(indentString_.size() - indentation_.size());
-}
-
-void BuiltStyledStreamWriter::writeCommentBeforeValue(Value const& root) {
-  if (cs_ == CommentStyle::None) return;
-  if (!root.hasComment(commentBefore))
-    return;
-
-  if (!indented_) writeIndent();
-  const std::string& comment = root.getComment(commentBefore);
-  std::string::const_iterator iter = comment.begin();
-  while (iter != comment.end()) {
-    sout_ << *iter;
-    if (*iter == '\n' &&
-       (iter != comment.end() && *(iter + 1) == '/'))
-      // writeIndent();  // would write extra newline
-      sout_ << indentString_;
-    ++iter;
-  }
-  indented_ = false;
-}
-
-void BuiltStyledStreamWriter::writeCommentAfterValueOnSameLine(Value const& root) {
-  if (cs_ == CommentStyle::None) return;
-  if (root.hasComment(commentAfterOnSameLine))
-    sout_ << " " + root.getComment(commentAfterOnSameLine);
-
-  if (root.hasComment(commentAfter)) {
-    writeIndent();
-    sout_ << root.getComment(commentAfter);
-  }
-}
-
-// static
-bool BuiltStyledStreamWriter::hasCommentForValue(const Value& value) {
-  return value.hasComment(commentBefore) ||
-         value.hasComment(commentAfterOnSameLine) ||
-         value.hasComment(commentAfter);
-}
 
 ///////////////
 // StreamWriter
@@ -886,25 +886,30 @@ void MainWindow::detectGPUType() {
 // User settings --------------------------------------------------------------
 
 bool MainWindow::loadConfigFile(QString filename) {
-  char *cstr;
   std::string fname = filename.toStdString();
-  cstr = new char[fname.size() + 1];
-  strcpy(cstr, fname.c_str());
 
-  std::ifstream file_id;
-  file_id.open(cstr);
-
-  Json::Reader reader;
-  Json::Value value;
-  if (!reader.parse(file_id, value)) {
+  if (!QFile::exists(filename)) {
     // qWarning("Couldn't open save file; creating file.");
     // new file just has default values
     saveConfigFile(filename);
-  } else {
-    m_osvrUser.read(value);
+    updateFormValues();
+    return true;
+  }
+
+  // decode straight into the user, no Json::Value tree is built
+  std::string errors;
+  bool loaded = m_osvrUser.readFile(fname, &errors);
+  if (!loaded) {
+    // keep the user's file as it is, they may want to fix it
+    QMessageBox::warning(
+        this, QString("User Settings"),
+        QString("Unable to read %1, the current values are shown instead. "
+                "The file was left unchanged.\n\n%2")
+            .arg(filename, QString::fromStdString(errors)),
+        QMessageBox::Ok);
   }
   updateFormValues();
-  return true;
+  return loaded;
 }
 
 void MainWindow::updateFormValues() {
@@ -992,13 +997,12 @@ void MainWindow::saveConfigFile(QString filename) {
   cstr = new char[fname.size() + 1];
   strcpy(cstr, fname.c_str());
 
-  Json::Value json;
-  m_osvrUser.write(json);
-
   std::ofstream out_file;
   out_file.open(cstr);
-  Json::StyledWriter styledWriter;
-  out_file << styledWriter.write(json);
+  Json::StreamSink sink(out_file);
+  Json::StreamingWriter writer(sink, Json::StreamingWriter::styledStyle);
+  m_osvrUser.write(writer);
+  writer.flush();
   out_file.close();
 }
 
@@ -207,80 +207,101 @@ void OSVRUser::setAddNear(eyeSide eyeBall, double addNear) {
   }
 }
 
-void OSVRUser::readPersonal(const Json::Value json) {
-  string gender = json["gender"].asString();
-
-  if (gender == "Male")
-    mGender = "Male";
-  else
-    mGender = "Female";
-
-  Json::Value anthro = json["anthropometric"];
-  mAnthropometric.standingEyeHeight = anthro["standingEyeHeight"].asDouble();
-  mAnthropometric.seatedEyeHeight = anthro["seatedEyeHeight"].asDouble();
-  mAnthropometric.eyeToNeck = anthro["eyeToNeck"].asDouble();
-
-  Json::Value eye;
-  eye = json["eyes"];
-  readEye(&mLeft, eye["left"]);
-  readEye(&mRight, eye["right"]);
-}
-
-void OSVRUser::readEye(eyeData *eD, const Json::Value json) {
-
-  eD->pupilDistance = json["pupilDistance"].asDouble();
-  eD->dominant = json["dominant"].asBool();
-
-  Json::Value correction;
-  correction = json["correction"];
+// Settings document --------------------------------------------------------
+
+// The members of the settings document, in name order: the order they are
+// written in, and that of the files written from a Json::Value before.
+namespace Json {
+
+template <> struct Binding<eyeData> {
+  template <typename Visitor, typename Eye>
+  static void describe(Visitor &visitor, Eye &eye) {
+    visitor.beginGroup("correction");
+    visitor.beginGroup("addNear");
+    visitor.field("spherical", eye.addNear);
+    visitor.endGroup();
+    visitor.beginGroup("distance");
+    visitor.field("axis", eye.correction.axis);
+    visitor.field("cylindrical", eye.correction.cylindrical);
+    visitor.field("spherical", eye.correction.spherical);
+    visitor.endGroup();
+    visitor.endGroup();
+    visitor.field("dominant", eye.dominant);
+    visitor.field("pupilDistance", eye.pupilDistance);
+  }
+};
+
+template <> struct Binding<OSVRUser::anthro> {
+  template <typename Visitor, typename Anthro>
+  static void describe(Visitor &visitor, Anthro &anthro) {
+    visitor.field("eyeToNeck", anthro.eyeToNeck);
+    visitor.field("seatedEyeHeight", anthro.seatedEyeHeight);
+    visitor.field("standingEyeHeight", anthro.standingEyeHeight);
+  }
+};
+
+template <> struct Binding<OSVRUser> {
+  template <typename Visitor, typename User>
+  static void describe(Visitor &visitor, User &user) {
+    visitor.beginGroup("personalSettings");
+    visitor.field("anthropometric", user.mAnthropometric);
+    visitor.beginGroup("eyes");
+    visitor.field("left", user.mLeft);
+    visitor.field("right", user.mRight);
+    visitor.endGroup();
+    visitor.field("gender", user.mGender);
+    visitor.endGroup();
+  }
+};
 
-  Json::Value distance = correction["distance"];
-  eD->correction.spherical = distance["spherical"].asDouble();
-  eD->correction.cylindrical = distance["cylindrical"].asDouble();
-  eD->correction.axis = distance["axis"].asDouble();
+} // namespace Json
 
-  Json::Value addNear = correction["addNear"];
-  eD->addNear = addNear["spherical"].asDouble();
+// Takes the settings of a user read from a document, where any gender but
+// "Male" stands for "Female".
+void OSVRUser::adopt(const OSVRUser &user) {
+  *this = user;
+  if (mGender != "Male")
+    mGender = "Female";
 }
 
-void OSVRUser::read(const Json::Value json) {
-  readPersonal(json["personalSettings"]);
+bool OSVRUser::read(const char *begin, const char *end, string *errors) {
+  OSVRUser user;
+  Json::BindingReader reader;
+  if (!reader.parse(begin, end, user)) {
+    if (errors)
+      *errors = reader.getFormattedErrorMessages();
+    return false;
+  }
+  adopt(user);
+  return true;
 }
 
-void OSVRUser::write(Json::Value &json) const {
-  Json::Value oo;
-  writePersonal(oo);
-  json["personalSettings"] = oo;
+bool OSVRUser::readFile(const string &path, string *errors) {
+  OSVRUser user;
+  Json::BindingReader reader;
+  if (!reader.parseFile(path, user)) {
+    if (errors)
+      *errors = reader.getFormattedErrorMessages();
+    return false;
+  }
+  adopt(user);
+  return true;
 }
 
-void OSVRUser::writePersonal(Json::Value &personalSettingsJson) const {
-  Json::Value anthropometricJson;
-  anthropometricJson["eyeToNeck"] = mAnthropometric.eyeToNeck;
-  anthropometricJson["seatedEyeHeight"] = mAnthropometric.seatedEyeHeight;
-  anthropometricJson["standingEyeHeight"] = mAnthropometric.standingEyeHeight;
-  personalSettingsJson["anthropometric"] = anthropometricJson;
-
-  Json::Value eyesJson, od, os;
-  writeEye(mLeft, os);
-  eyesJson["left"] = os;
-  writeEye(mRight, od);
-  eyesJson["right"] = od;
-  personalSettingsJson["gender"] = mGender;
-  personalSettingsJson["eyes"] = eyesJson;
+#if defined(_WIN32)
+bool OSVRUser::readFile(const wstring &path, string *errors) {
+  OSVRUser user;
+  Json::BindingReader reader;
+  if (!reader.parseFile(path, user)) {
+    if (errors)
+      *errors = reader.getFormattedErrorMessages();
+    return false;
+  }
+  adopt(user);
+  return true;
 }
+#endif
 
-void OSVRUser::writeEye(eyeData e, Json::Value &eyeJson) const {
-  eyeJson["dominant"] = e.dominant;
-  eyeJson["pupilDistance"] = e.pupilDistance;
-
-  Json::Value distance;
-  distance["axis"] = e.correction.axis;
-  distance["cylindrical"] = e.correction.cylindrical;
-  distance["spherical"] = e.correction.spherical;
-
-  Json::Value correction, near;
-  near["spherical"] = e.addNear;
-  correction["addNear"] = near;
-  correction["distance"] = distance;
-  eyeJson["correction"] = correction;
+void OSVRUser::write(Json::StreamingWriter &writer) const {
+  Json::writeObject(writer, *this);
 }
@@ -70,14 +70,25 @@ public:
   double eyeToNeck() const;
   void setEyeToNeck(double eyeToNeck);
 
-  void read(const Json::Value json);
-  void readPersonal(const Json::Value json);
-  void readEye(eyeData *e, const Json::Value json);
-  void write(Json::Value &json) const;
-  void writePersonal(Json::Value &personalSettingsJson) const;
-  void writeEye(eyeData e, Json::Value &eyeJson) const;
+  // Decode a settings document straight into this user, without building a
+  // Json::Value tree. The user is left unchanged if the file can not be
+  // opened, or if the document can not be parsed or holds a value of the
+  // wrong type; the reasons are then stored in errors, if not null.
+  bool read(const char *begin, const char *end, string *errors = 0);
+  bool readFile(const string &path, string *errors = 0);
+#if defined(_WIN32)
+  bool readFile(const wstring &path, string *errors = 0);
+#endif
+
+  // Write the settings document as it is produced, members in name order.
+  void write(Json::StreamingWriter &writer) const;
 
 private:
+  // Members read from and written to the settings document.
+  friend struct Json::Binding<OSVRUser>;
+
+  void adopt(const OSVRUser &user);
+
   string mGender;
   eyeData mLeft;
   eyeData mRight;
@@ -86,6 +97,7 @@ private:
     double seatedEyeHeight;
     double eyeToNeck;
   } mAnthropometric;
+  friend struct Json::Binding<anthro>;
 };
 
 #endif // OSVRUSER_H
@@ -0,0 +1,499 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#include <json/json.h>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Regression tests of the library. Each test returns the number of failed
+// checks, and the program exits with the total.
+
+static int failures = 0;
+
+#define JSONTEST_ASSERT_EQUAL(expected, actual)                               \
+  checkEqual(expected, actual, __FILE__, __LINE__, #actual)
+
+static void checkEqual(const std::string& expected,
+                       const std::string& actual,
+                       const char* file,
+                       int line,
+                       const char* expression) {
+  if (expected == actual)
+    return;
+  ++failures;
+  printf("%s(%d): %s\n  expected: %s\n  actual:   %s\n",
+         file,
+         line,
+         expression,
+         expected.c_str(),
+         actual.c_str());
+}
+
+static std::string write(const Json::Value& value) {
+  Json::FastWriter writer;
+  writer.omitEndingLineFeed();
+  return writer.write(value);
+}
+
+// Values stored into their own tree, or into a tree they hold, are copies:
+// with JSON_COPY_ON_WRITE, no container may end up holding itself.
+static void testStoreIntoSelf() {
+  Json::Value a(Json::arrayValue);
+  a.append(1);
+  a.append(a);
+  JSONTEST_ASSERT_EQUAL("[1,[1]]", write(a));
+
+  Json::Value b(Json::arrayValue);
+  b.append(Json::arrayValue);
+  b[0u].append(b);
+  JSONTEST_ASSERT_EQUAL("[[[[]]]]", write(b));
+  b[0u][0u].append(b);
+  JSONTEST_ASSERT_EQUAL("[[[[],[[[[]]]]]]]", write(b));
+
+  Json::Value o(Json::objectValue);
+  o["n"] = 1;
+  Json::Value& k = o["k"];
+  k = o;
+  JSONTEST_ASSERT_EQUAL("{\"k\":{\"k\":null,\"n\":1},\"n\":1}", write(o));
+  o["k"]["k"] = o;
+  JSONTEST_ASSERT_EQUAL(
+      "{\"k\":{\"k\":{\"k\":{\"k\":null,\"n\":1},\"n\":1},\"n\":1},\"n\":1}",
+      write(o));
+  JSONTEST_ASSERT_EQUAL("false", o == o["k"] ? "true" : "false");
+}
+
+// Modifying a copy, or the value it was copied from, leaves the other one
+// unchanged.
+static void testCopiesAreIndependent() {
+  Json::Value a(Json::arrayValue);
+  a.append(Json::objectValue)["x"] = 1;
+  Json::Value copy = a;
+  a[0u]["x"] = 2;
+  copy.append(3);
+  JSONTEST_ASSERT_EQUAL("[{\"x\":2}]", write(a));
+  JSONTEST_ASSERT_EQUAL("[{\"x\":1},3]", write(copy));
+}
+
+// Members are sorted whatever their order in the text, including in
+// objects left open by an error, and a repeated name keeps its last value.
+static void testParsedMembersAreSorted() {
+  std::string document = "{";
+  std::string expected = "{";
+  for (int index = 99; index >= 0; --index) {
+    char name[16];
+    sprintf(name, "\"%02d\":%d", index, index);
+    document += name;
+    document += ",";
+  }
+  for (int index = 0; index != 100; ++index) {
+    char name[16];
+    sprintf(name, "\"%02d\":%d", index, index == 42 ? -1 : index);
+    expected += index ? "," : "";
+    expected += name;
+  }
+  document += "\"42\":-1,\"z\":{\"b\":1,\"a\":2}}";
+  expected += ",\"z\":{\"a\":2,\"b\":1}}";
+
+  Json::Reader reader;
+  Json::Value root;
+  reader.parse(document, root);
+  JSONTEST_ASSERT_EQUAL(expected, write(root));
+
+  Json::LazyDocument lazy;
+  lazy.parse(document);
+  JSONTEST_ASSERT_EQUAL(expected, write(lazy.root().materialize()));
+
+  reader.parse("{\"b\":1,\"a\":{\"d\":1,\"c\":", root);
+  JSONTEST_ASSERT_EQUAL("{\"a\":{\"c\":null,\"d\":1},\"b\":1}",
+                        write(root));
+}
+
+// The parsed value of a number token, in hexadecimal so that every bit
+// shows, or "error".
+static std::string parsedDouble(const std::string& token) {
+  Json::Reader reader;
+  Json::Value root;
+  if (!reader.parse("[" + token + "]", root))
+    return "error";
+  char buffer[64];
+  sprintf(buffer, "%a", root[0u].asDouble());
+  return buffer;
+}
+
+static std::string strtodDouble(const std::string& token) {
+  char buffer[64];
+  sprintf(buffer, "%a", strtod(token.c_str(), 0));
+  return buffer;
+}
+
+// Reals are rounded to nearest, ties to even, like strtod().
+static void testParseDouble() {
+  static const char* const cases[][2] = {
+      // Halfway between two doubles, and just above.
+      {"9007199254740993.0", "0x1p+53"},
+      {"9007199254740993e0", "0x1p+53"},
+      {"9007199254740995.0", "0x1.0000000000002p+53"},
+      {"9007199254740993.0000000000000001", "0x1.0000000000001p+53"},
+      // Subnormals, and halfway to the smallest one.
+      {"4.9e-324", "0x0.0000000000001p-1022"},
+      {"5e-324", "0x0.0000000000001p-1022"},
+      {"2.4703282292062327e-324", "0x0p+0"},
+      {"2.4703282292062328e-324", "0x0.0000000000001p-1022"},
+      {"2.2250738585072011e-308", "0x0.fffffffffffffp-1022"},
+      {"2.2250738585072014e-308", "0x1p-1022"},
+      {"1e-400", "0x0p+0"},
+      {"-1e-400", "-0x0p+0"},
+      // Largest double, and overflow.
+      {"1.7976931348623157e308", "0x1.fffffffffffffp+1023"},
+      {"1.7976931348623158e308", "0x1.fffffffffffffp+1023"},
+      {"1.7976931348623159e308", "inf"},
+      {"1e309", "inf"},
+      {"-1e309", "-inf"},
+      // Zeros keep their sign.
+      {"0.0", "0x0p+0"},
+      {"-0.0", "-0x0p+0"},
+      {"0e10", "0x0p+0"},
+      {"-0e-10", "-0x0p+0"},
+      // 19 and 20 digit mantissas.
+      {"1234567890123456789e-5", "0x1.674e79c5fe523p+43"},
+      {"9999999999999999999.0", "0x1.158e460913dp+63"},
+      {"12345678901234567890e-3", "0x1.5ee2a2eb5a5c4p+53"},
+      {"18446744073709551615e0", "0x1p+64"},
+      {"18446744073709551617", "0x1p+64"},
+      {"-18446744073709551616", "-0x1p+64"}};
+  for (size_t index = 0; index != sizeof(cases) / sizeof(cases[0]); ++index)
+    JSONTEST_ASSERT_EQUAL(cases[index][1], parsedDouble(cases[index][0]));
+
+  // Over 800 digits, past what the big decimal fallback keeps: the digits
+  // it drops still decide halfway cases.
+  std::string zeros(850, '0');
+  JSONTEST_ASSERT_EQUAL("0x1p+53",
+                        parsedDouble("9007199254740993" + zeros + "e-850"));
+  JSONTEST_ASSERT_EQUAL(
+      "0x1.0000000000001p+53",
+      parsedDouble("9007199254740993" + zeros + "1e-851"));
+  JSONTEST_ASSERT_EQUAL("0x1p+0", parsedDouble("1." + zeros));
+  JSONTEST_ASSERT_EQUAL("0x1.999999999999ap-4",
+                        parsedDouble("0." + zeros + "1e850"));
+
+#if defined(JSON_HAS_INT64)
+  // Random tokens, compared with the C library.
+  unsigned int seed = 12345;
+  for (int count = 0; count != 200000; ++count) {
+    std::string token;
+    seed = seed * 1103515245 + 12345;
+    // Now and then, more digits than the big decimal fallback keeps.
+    int digits = 1 + int(seed >> 16) % ((seed & 0x3f00) ? 25 : 1000);
+    int point = int(seed >> 8) % (digits + 1);
+    for (int digit = 0; digit != digits; ++digit) {
+      seed = seed * 1103515245 + 12345;
+      if (digit == point && digit != 0)
+        token += '.';
+      token += char('0' + (seed >> 16) % 10);
+    }
+    seed = seed * 1103515245 + 12345;
+    char exponent[16];
+    sprintf(exponent, "e%d", int(seed >> 16) % 680 - 350);
+    token += exponent;
+    if (token[0] == '0' && token.size() > 1 && token[1] != '.' &&
+        token[1] != 'e')
+      token.erase(0, 1); // JSON allows no leading zero.
+    JSONTEST_ASSERT_EQUAL(strtodDouble(token), parsedDouble(token));
+  }
+#endif
+}
+
+// Doubles are written as the shortest string that reads back as the same
+// double.
+static void testWriteDouble() {
+  JSONTEST_ASSERT_EQUAL("32.49999999999999",
+                        Json::valueToString(32.499999999999993));
+  JSONTEST_ASSERT_EQUAL("5e-324", Json::valueToString(5e-324));
+  JSONTEST_ASSERT_EQUAL("1.7976931348623157e+308",
+                        Json::valueToString(DBL_MAX));
+  JSONTEST_ASSERT_EQUAL("1e+21", Json::valueToString(1e21));
+  JSONTEST_ASSERT_EQUAL("0.1", Json::valueToString(0.1));
+  JSONTEST_ASSERT_EQUAL("-0", Json::valueToString(-0.0));
+  JSONTEST_ASSERT_EQUAL("10000000000000000", Json::valueToString(1e16));
+  JSONTEST_ASSERT_EQUAL("1e-05", Json::valueToString(0.00001));
+  // Doubles Grisu2 alone writes with one more digit.
+  JSONTEST_ASSERT_EQUAL("2.718316374298659e+276",
+                        Json::valueToString(2.718316374298659e+276));
+  JSONTEST_ASSERT_EQUAL("4.098020844065463e-12",
+                        Json::valueToString(4.098020844065463e-12));
+
+  // Random doubles read back exactly, and no shorter string would.
+  unsigned int seed = 54321;
+  for (int count = 0; count != 20000; ++count) {
+    unsigned int words[2];
+    for (int word = 0; word != 2; ++word) {
+      seed = seed * 1103515245 + 12345;
+      words[word] = seed >> 16;
+      seed = seed * 1103515245 + 12345;
+      words[word] = (words[word] << 16) | (seed >> 16);
+    }
+    Json::UInt64 bits = (Json::UInt64(words[0]) << 32) | words[1];
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    if (value != value || value - value != 0)
+      continue; // NaN or infinity
+    std::string text = Json::valueToString(value);
+    JSONTEST_ASSERT_EQUAL(strtodDouble(text), parsedDouble(text));
+    char buffer[64];
+    sprintf(buffer, "%a", value);
+    JSONTEST_ASSERT_EQUAL(buffer, parsedDouble(text));
+
+    size_t first = text.find_first_of("123456789");
+    size_t last = text.find_last_of("123456789", text.find('e'));
+    int digits = 0;
+    for (size_t index = first; index <= last; ++index)
+      digits += text[index] != '.';
+    if (digits > 1) {
+      sprintf(buffer, "%.*e", digits - 2, value);
+      if (strtod(buffer, 0) == value)
+        JSONTEST_ASSERT_EQUAL(buffer, text);
+    }
+  }
+}
+
+// Comments and source offsets of a tree, one value per line.
+static std::string describe(const Json::Value& value,
+                            const std::string& path = "") {
+  char offsets[64];
+  sprintf(offsets,
+          " %d-%d",
+          int(value.getOffsetStart()),
+          int(value.getOffsetLimit()));
+  std::string text = path + offsets;
+  for (int placement = 0; placement != Json::numberOfCommentPlacement;
+       ++placement) {
+    if (value.hasComment(Json::CommentPlacement(placement)))
+      text += " " + value.getComment(Json::CommentPlacement(placement));
+  }
+  text += "\n";
+  if (value.isArray()) {
+    for (Json::ArrayIndex index = 0; index != value.size(); ++index)
+      text += describe(value[index], path + "/" + char('0' + index % 10));
+  } else if (value.isObject()) {
+    Json::Value::Members names = value.getMemberNames();
+    for (size_t index = 0; index != names.size(); ++index)
+      text += describe(value[names[index]], path + "/" + names[index]);
+  }
+  return text;
+}
+
+// Comments and offsets, kept out of line with JSON_COMPACT_VALUE, follow
+// the values they belong to and go away with them.
+static void testCommentsAndOffsetsFollowValues() {
+  const std::string document = "// head\n"
+                               "{\n"
+                               "  \"a\": 1, // one\n"
+                               "  \"b\": [true, /* two */ \"text\"]\n"
+                               "}\n";
+  Json::Reader reader;
+  Json::Value root;
+  reader.parse(document, root, true);
+  const std::string expected = describe(root);
+  JSONTEST_ASSERT_EQUAL(" 8-60 // head\n"
+                        "/a 17-18 // one\n"
+                        "/b 34-58\n"
+                        "/b/0 35-39 /* two */\n"
+                        "/b/1 51-57\n",
+                        expected);
+
+  Json::Value copy = root;
+  JSONTEST_ASSERT_EQUAL(expected, describe(copy));
+  copy["a"].setComment("// changed", Json::commentAfterOnSameLine);
+  JSONTEST_ASSERT_EQUAL(expected, describe(root));
+#if JSON_HAS_RVALUE_REFERENCES
+  Json::Value moved(std::move(copy));
+  JSONTEST_ASSERT_EQUAL(" 0-0\n", describe(copy));
+#else
+  Json::Value moved(copy);
+#endif
+  JSONTEST_ASSERT_EQUAL("// changed", moved["a"].getComment(
+                                          Json::commentAfterOnSameLine));
+
+  // swap() exchanges comments and offsets too, swapPayload() does not.
+  Json::Value other(2);
+  other.setComment("// other", Json::commentBefore);
+  other.swap(root["a"]);
+  JSONTEST_ASSERT_EQUAL("/a 17-18 // one\n", describe(other, "/a"));
+  JSONTEST_ASSERT_EQUAL("/a 0-0 // other\n", describe(root["a"], "/a"));
+  other.swapPayload(root["a"]);
+  JSONTEST_ASSERT_EQUAL("/a 17-18 // one\n", describe(other, "/a"));
+  JSONTEST_ASSERT_EQUAL("2", write(other));
+
+  // Values made where others were destroyed start without any.
+  root.removeMember("b");
+  root = Json::Value();
+  other = Json::Value();
+  moved = Json::Value();
+  Json::Value rebuilt(Json::objectValue);
+  rebuilt["a"] = 1;
+  rebuilt["b"].append(true);
+  rebuilt["b"].append("text");
+  JSONTEST_ASSERT_EQUAL(" 0-0\n/a 0-0\n/b 0-0\n/b/0 0-0\n/b/1 0-0\n",
+                        describe(rebuilt));
+}
+
+static std::string hexBytes(const std::string& bytes) {
+  std::string hex;
+  for (size_t index = 0; index != bytes.size(); ++index) {
+    char buffer[4];
+    sprintf(buffer, "%02X", static_cast<unsigned char>(bytes[index]));
+    hex += buffer;
+  }
+  return hex;
+}
+
+// The bytes of a parsed string in hexadecimal, or "error".
+static std::string parsedString(const std::string& text, bool strict) {
+  Json::Reader reader(strict ? Json::Features::strictMode()
+                             : Json::Features::all());
+  Json::Value root;
+  if (!reader.parse("[\"" + text + "\"]", root))
+    return "error";
+  return hexBytes(root[0u].asString());
+}
+
+// Strict mode only accepts valid UTF-8 and paired surrogates, whatever
+// the position of a sequence in the blocks the scanners work on.
+static void testValidateUTF8() {
+  JSONTEST_ASSERT_EQUAL("C080", parsedString("\xC0\x80", false));
+  JSONTEST_ASSERT_EQUAL("error", parsedString("\xC0\x80", true));
+  JSONTEST_ASSERT_EQUAL("EDA080", parsedString("\xED\xA0\x80", false));
+  JSONTEST_ASSERT_EQUAL("error", parsedString("\xED\xA0\x80", true));
+  JSONTEST_ASSERT_EQUAL("F4908080", parsedString("\xF4\x90\x80\x80", false));
+  JSONTEST_ASSERT_EQUAL("error", parsedString("\xF4\x90\x80\x80", true));
+  JSONTEST_ASSERT_EQUAL("F48FBFBF", parsedString("\xF4\x8F\xBF\xBF", true));
+
+  JSONTEST_ASSERT_EQUAL("F09F9880", parsedString("\\ud83d\\ude00", false));
+  JSONTEST_ASSERT_EQUAL("F09F9880", parsedString("\\ud83d\\ude00", true));
+  JSONTEST_ASSERT_EQUAL("EDB080", parsedString("\\udc00", false));
+  JSONTEST_ASSERT_EQUAL("error", parsedString("\\udc00", true));
+  JSONTEST_ASSERT_EQUAL("error", parsedString("\\ud83d\\u0041", true));
+
+  // Sequences whole or cut short, across the 16 and 32 byte block edges.
+  static const char* const sequences[] = {"\xC3\xA9", "\xE4\xB8\xAD",
+                                          "\xF0\x9F\x98\x80"};
+  for (size_t prefix = 0; prefix != 40; ++prefix) {
+    for (size_t kind = 0; kind != 3; ++kind) {
+      const std::string sequence = sequences[kind];
+      std::string text = std::string(prefix, 'a') + sequence + "z";
+      JSONTEST_ASSERT_EQUAL(hexBytes(text), parsedString(text, true));
+      for (size_t cut = 1; cut != sequence.size(); ++cut) {
+        text = std::string(prefix, 'a') + sequence.substr(0, cut) + "z";
+        JSONTEST_ASSERT_EQUAL("error", parsedString(text, true));
+        text = std::string(prefix, 'a') + sequence.substr(0, cut);
+        JSONTEST_ASSERT_EQUAL("error", parsedString(text, true));
+      }
+    }
+  }
+}
+
+// Reader::reparse() after an edit gives the same tree, offsets, comments
+// and errors as parsing the edited document from scratch.
+static void checkReparse(const std::string& oldDocument,
+                         const std::string& newDocument) {
+  Json::Reader reader;
+  Json::Value root;
+  reader.parse(oldDocument, root, true);
+  bool reparsed = reader.reparse(oldDocument, root, newDocument, true);
+
+  Json::Reader freshReader;
+  Json::Value fresh;
+  bool parsed = freshReader.parse(newDocument, fresh, true);
+  JSONTEST_ASSERT_EQUAL(parsed ? "parsed" : "failed",
+                        reparsed ? "parsed" : "failed");
+  if (!parsed) {
+    JSONTEST_ASSERT_EQUAL(freshReader.getFormattedErrorMessages(),
+                          reader.getFormattedErrorMessages());
+    return;
+  }
+  JSONTEST_ASSERT_EQUAL(write(fresh), write(root));
+  JSONTEST_ASSERT_EQUAL(describe(fresh), describe(root));
+}
+
+static void testReparse() {
+  const std::string document =
+      "{\"name\": \"hello\", \"list\": [1, [2, 3], {\"x\": true}],\n"
+      " \"nested\": {\"a\": {\"b\": \"deep\"}, \"c\": 4.5}, \"last\": null}";
+  // Within a string.
+  checkReparse(document, "{\"name\": \"hello world\", \"list\": [1, [2, 3], "
+                         "{\"x\": true}],\n \"nested\": {\"a\": {\"b\": "
+                         "\"deep\"}, \"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"name\": \"he\", \"list\": [1, [2, 3], {\"x\": "
+                         "true}],\n \"nested\": {\"a\": {\"b\": \"deep\"}, "
+                         "\"c\": 4.5}, \"last\": null}");
+  // Changing the type of a value.
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, [2, 3], {\"x\": "
+                         "\"true\"}],\n \"nested\": {\"a\": {\"b\": \"deep\"}, "
+                         "\"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, {\"2\": 3}, "
+                         "{\"x\": true}],\n \"nested\": {\"a\": {\"b\": "
+                         "\"deep\"}, \"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, [2, 3], {\"x\": "
+                         "true}],\n \"nested\": {\"a\": [\"deep\"], \"c\": "
+                         "4.5}, \"last\": null}");
+  // Adding and removing elements and members.
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, [2, 3, 4], "
+                         "{\"x\": true}],\n \"nested\": {\"a\": {\"b\": "
+                         "\"deep\"}, \"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [[2, 3], {\"x\": "
+                         "true}],\n \"nested\": {\"a\": {\"b\": \"deep\"}, "
+                         "\"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, [2, 3], {\"x\": "
+                         "true, \"y\": false}],\n \"nested\": {\"a\": {\"b\": "
+                         "\"deep\"}, \"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, [2, 3], {\"x\": "
+                         "true}],\n \"nested\": {\"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"list\": [1, [2, 3], {\"x\": true}],\n "
+                         "\"nested\": {\"a\": {\"b\": \"deep\"}, \"c\": 4.5}, "
+                         "\"last\": null}");
+  // Making the document invalid.
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, [2, 3, ], "
+                         "{\"x\": true}],\n \"nested\": {\"a\": {\"b\": "
+                         "\"deep\"}, \"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, [2, 3], {\"x\": "
+                         "tru}],\n \"nested\": {\"a\": {\"b\": \"deep\"}, "
+                         "\"c\": 4.5}, \"last\": null}");
+  checkReparse(document, "{\"name\": \"hello\", \"list\": [1, [2, 3], {\"x\": "
+                         "true}],\n \"nested\": {\"a\": {\"b\": \"deep\"}, "
+                         "\"c\": 4.5}, \"last\": null");
+
+  // Touching a comment, or a value next to one.
+  const std::string commented =
+      "{\"a\": 1, // one\n \"b\": [2, /* two */ 3], \"c\": {\"d\": 4}}";
+  checkReparse(commented,
+               "{\"a\": 1, // one more\n \"b\": [2, /* two */ 3], \"c\": "
+               "{\"d\": 4}}");
+  checkReparse(commented,
+               "{\"a\": 1, // one\n \"b\": [2, /* two */ 33], \"c\": "
+               "{\"d\": 4}}");
+  checkReparse(commented,
+               "{\"a\": 1, // one\n \"b\": [2, /* two */ 3], \"c\": "
+               "{\"d\": 44}}");
+  checkReparse(commented,
+               "{\"a\": 1, // one\n \"b\": [2, /* two  3], \"c\": "
+               "{\"d\": 4}}");
+}
+
+int main() {
+  testStoreIntoSelf();
+  testCopiesAreIndependent();
+  testParsedMembersAreSorted();
+  testParseDouble();
+  testWriteDouble();
+  testCommentsAndOffsetsFollowValues();
+  testValidateUTF8();
+  testReparse();
+  if (failures)
+    printf("%d check(s) failed\n", failures);
+  return failures;
+}
@@ -93,36 +93,40 @@ public:
 
   void readConfigFile(wstring file_locator) {
 
-    std::ifstream file_id;
-    file_id.open(file_locator);
-
-    Json::Reader reader;
-    Json::Value value;
-    if (!reader.parse(file_id, value)) {
+    bool missing = false;
+    if (GetFileAttributesW(file_locator.c_str()) == INVALID_FILE_ATTRIBUTES) {
+      DWORD error = GetLastError();
+      missing = error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND;
+    }
+    if (missing) {
       std::cout
           << "USER_SETTINGS_PLUGIN: Couldn't open save file, creating file.\n";
-      // close file first just in case...
-      file_id.close();
       // new file just has default values
       writeConfigFile(file_locator);
-    } else {
-      m_osvrUser.read(value);
-      file_id.close();
+      return;
+    }
+
+    // decode straight from a mapping of the file into the user, without
+    // intermediate copies or a Json::Value tree
+    std::string errors;
+    if (!m_osvrUser.readFile(file_locator, &errors)) {
+      // keep the user's file as it is, they may want to fix it
+      std::cout << "USER_SETTINGS_PLUGIN: Couldn't read save file, keeping "
+                   "the current settings.\n"
+                << errors;
     }
   };
 
   void writeConfigFile(wstring file_locator) {
-    // retreive Json string. should be just the default values.
-    Json::Value value;
-    m_osvrUser.write(value);
-
     // open the file
     std::ofstream file_id;
     file_id.open(file_locator);
 
-    // write the json structure to the file
-    Json::StyledWriter styledWriter;
-    file_id << styledWriter.write(value);
+    // write the settings to the file. should be just the default values.
+    Json::StreamSink sink(file_id);
+    Json::StreamingWriter writer(sink, Json::StreamingWriter::styledStyle);
+    m_osvrUser.write(writer);
+    writer.flush();
     file_id.close();
   };
 